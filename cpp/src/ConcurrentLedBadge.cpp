@@ -0,0 +1,547 @@
+/*             C O N C U R R E N T L E D B A D G E . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <thread>
+
+#include "ConcurrentLedBadge.h"
+
+
+// the settings of a bank or the header, one byte per field
+static const size_t BlinkingField       = 0;
+static const size_t AnimatedBorderField = 1;
+static const size_t ModeField           = 2;
+static const size_t SpeedField          = 3;
+static const size_t BrightnessField     = 0;
+static const size_t TimeField           = 1; // 6 bytes: year, month, day, hour, minute, second
+
+
+static inline unsigned char GetField
+(
+    unsigned long long settings,
+    size_t             field
+) {
+    return static_cast<unsigned char>(settings >> (8 * field));
+}
+
+
+static inline void SetField
+(
+    unsigned long long& settings,
+    size_t              field,
+    unsigned char       value
+) {
+    settings = (settings & ~(0xffull << (8 * field))) | (static_cast<unsigned long long>(value) << (8 * field));
+}
+
+
+// the published word: 2 bits per row for its current version, the higher bits
+// count the publications, so a word whose versions were reused in a cycle
+// does not compare equal to an old one
+static const size_t RowBits = 18; // 2 bits for each of up to 8 banks and the header
+
+
+// the current version of a bank or the header in the published word
+static inline size_t GetCurrent
+(
+    unsigned long long current,
+    size_t             row
+) {
+    return static_cast<size_t>((current >> (2 * row)) & 3);
+}
+
+
+static inline unsigned long long Publish
+(
+    unsigned long long current,
+    size_t             row,
+    size_t             version
+) {
+    unsigned long long generation = (current >> RowBits) + 1;
+    unsigned long long rows       = current & ((1ull << RowBits) - 1);
+
+    rows = (rows & ~(3ull << (2 * row))) | (static_cast<unsigned long long>(version) << (2 * row));
+
+    return (generation << RowBits) | rows;
+}
+
+
+template <class Geometry>
+BasicConcurrentLedBadge<Geometry>::BasicConcurrentLedBadge
+(
+    std::function<void(const char* logString)>* logHandler
+) : m_logHandler(logHandler), m_versions(), m_current(0) {
+    static_assert(Versions <= 4, "ConcurrentLedBadge: the published word has 2 bits per version number");
+    static_assert(2 * (Banks + 1) <= RowBits, "ConcurrentLedBadge: the published word has no space for the generation");
+
+    unsigned long long bankSettings = 0;
+
+    SetField(bankSettings, SpeedField, static_cast<unsigned char>(Speed::Five));
+
+    for (size_t row = 0; row <= Banks; ++row) {
+        for (size_t version = 0; version < Versions; ++version) {
+            Version& slot = m_versions[row][version];
+
+            slot.sequence.store(0);
+            slot.owned.store(false);
+            slot.settings.store((row == HeaderRow) ? 0 : bankSettings);
+            slot.size.store(0);
+
+            if (row != HeaderRow)
+                slot.data.reset(new std::atomic<unsigned long long>[DataWords]());
+        }
+    }
+}
+
+
+template <class Geometry>
+BasicConcurrentLedBadge<Geometry>::~BasicConcurrentLedBadge(void) {}
+
+
+template <class Geometry>
+BasicConcurrentLedBadge<Geometry>::MemoryBank::MemoryBank
+(
+    const MemoryBank& original
+) : m_parent(original.m_parent), m_index(original.m_index) {
+    assert(m_parent != nullptr);
+    assert(m_index < Banks);
+}
+
+
+template <class Geometry>
+BasicConcurrentLedBadge<Geometry>::MemoryBank::~MemoryBank(void) {}
+
+
+template <class Geometry>
+typename BasicConcurrentLedBadge<Geometry>::MemoryBank& BasicConcurrentLedBadge<Geometry>::MemoryBank::operator=
+(
+    const MemoryBank& original
+) {
+    if (this != &original) {
+        m_parent = original.m_parent;
+        m_index  = original.m_index;
+    }
+
+    assert(m_parent != nullptr);
+    assert(m_index < Banks);
+
+    return *this;
+}
+
+
+template <class Geometry>
+void BasicConcurrentLedBadge<Geometry>::MemoryBank::SetBlinking
+(
+    bool on
+) {
+    if ((m_parent != nullptr) && (m_index < Banks))
+        m_parent->Update(m_index, [on](Content& content) {SetField(content.settings, BlinkingField, on ? 1 : 0);});
+}
+
+
+template <class Geometry>
+void BasicConcurrentLedBadge<Geometry>::MemoryBank::SetAnimatedBorder
+(
+    bool on
+) {
+    if ((m_parent != nullptr) && (m_index < Banks))
+        m_parent->Update(m_index, [on](Content& content) {SetField(content.settings, AnimatedBorderField, on ? 1 : 0);});
+}
+
+
+template <class Geometry>
+void BasicConcurrentLedBadge<Geometry>::MemoryBank::SetMode
+(
+    Mode value
+) {
+    if ((m_parent != nullptr) && (m_index < Banks))
+        m_parent->Update(m_index, [value](Content& content) {SetField(content.settings, ModeField, static_cast<unsigned char>(value));});
+}
+
+
+template <class Geometry>
+void BasicConcurrentLedBadge<Geometry>::MemoryBank::SetSpeed
+(
+    Speed value
+) {
+    if ((m_parent != nullptr) && (m_index < Banks))
+        m_parent->Update(m_index, [value](Content& content) {SetField(content.settings, SpeedField, static_cast<unsigned char>(value));});
+}
+
+
+// the data is encoded by a private LedBadge in the calling thread,
+// only the publication of the result is shared
+template <class Geometry>
+bool BasicConcurrentLedBadge<Geometry>::MemoryBank::SetData
+(
+    size_t                                         length,
+    const std::function<bool(size_t x, size_t y)>& ledOn
+) {
+    bool ret = false;
+
+    if ((m_parent != nullptr) && (m_index < Banks)) {
+        BasicLedBadge<Geometry>    encoder(m_parent->m_logHandler);
+        std::vector<unsigned char> encoded;
+        size_t                     bankOffset = 0;
+        size_t                     bankSize   = 0;
+
+        if (encoder.GetMemoryBank(0).SetData(length, ledOn) &&
+            encoder.FetchData(encoded) &&
+            BasicLedBadge<Geometry>::FindBankData(encoded.data(), encoded.size(), 0, bankOffset, bankSize)) {
+            m_parent->Update(m_index, [&encoded, bankOffset, bankSize](Content& content) {
+                content.data.assign(encoded.begin() + bankOffset, encoded.begin() + bankOffset + bankSize);
+            });
+            ret = true;
+        }
+    }
+
+    return ret;
+}
+
+
+template <class Geometry>
+bool BasicConcurrentLedBadge<Geometry>::MemoryBank::SetPackedData
+(
+    const unsigned char* data,
+    size_t               size
+) {
+    bool ret = false;
+
+    if ((m_parent != nullptr) && (m_index < Banks)) {
+        // checked and trimmed like in the LedBadge
+        BasicLedBadge<Geometry>    encoder(m_parent->m_logHandler);
+        std::vector<unsigned char> encoded;
+        size_t                     bankOffset = 0;
+        size_t                     bankSize   = 0;
+
+        if (encoder.GetMemoryBank(0).SetPackedData(data, size) &&
+            encoder.FetchData(encoded) &&
+            BasicLedBadge<Geometry>::FindBankData(encoded.data(), encoded.size(), 0, bankOffset, bankSize)) {
+            m_parent->Update(m_index, [&encoded, bankOffset, bankSize](Content& content) {
+                content.data.assign(encoded.begin() + bankOffset, encoded.begin() + bankOffset + bankSize);
+            });
+            ret = true;
+        }
+    }
+
+    return ret;
+}
+
+
+template <class Geometry>
+BasicConcurrentLedBadge<Geometry>::MemoryBank::MemoryBank
+(
+    BasicConcurrentLedBadge* parent,
+    size_t                   index
+) : m_parent(parent), m_index(index) {
+    assert(m_parent != nullptr);
+    assert(m_index < Banks);
+}
+
+
+template <class Geometry>
+void BasicConcurrentLedBadge<Geometry>::SetBrightness
+(
+    Brightness value
+) {
+    Update(HeaderRow, [value](Content& content) {SetField(content.settings, BrightnessField, static_cast<unsigned char>(value));});
+}
+
+
+template <class Geometry>
+typename BasicConcurrentLedBadge<Geometry>::MemoryBank BasicConcurrentLedBadge<Geometry>::GetMemoryBank
+(
+    size_t index
+) {
+    assert(index < Banks);
+
+    return MemoryBank(this, index);
+}
+
+
+template <class Geometry>
+void BasicConcurrentLedBadge<Geometry>::SetYear
+(
+    unsigned char value
+) {
+    Update(HeaderRow, [value](Content& content) {SetField(content.settings, TimeField + 0, value);});
+}
+
+
+template <class Geometry>
+void BasicConcurrentLedBadge<Geometry>::SetMonth
+(
+    unsigned char value
+) {
+    Update(HeaderRow, [value](Content& content) {SetField(content.settings, TimeField + 1, value);});
+}
+
+
+template <class Geometry>
+void BasicConcurrentLedBadge<Geometry>::SetDay
+(
+    unsigned char value
+) {
+    Update(HeaderRow, [value](Content& content) {SetField(content.settings, TimeField + 2, value);});
+}
+
+
+template <class Geometry>
+void BasicConcurrentLedBadge<Geometry>::SetHour
+(
+    unsigned char value
+) {
+    Update(HeaderRow, [value](Content& content) {SetField(content.settings, TimeField + 3, value);});
+}
+
+
+template <class Geometry>
+void BasicConcurrentLedBadge<Geometry>::SetMinute
+(
+    unsigned char value
+) {
+    Update(HeaderRow, [value](Content& content) {SetField(content.settings, TimeField + 4, value);});
+}
+
+
+template <class Geometry>
+void BasicConcurrentLedBadge<Geometry>::SetSecond
+(
+    unsigned char value
+) {
+    Update(HeaderRow, [value](Content& content) {SetField(content.settings, TimeField + 5, value);});
+}
+
+
+// The published word names the versions of one point in time.  A version
+// which was reused by a writer while it was copied fails its sequence check,
+// and if the word changed while the versions were copied they may be of
+// different points in time.  Then the word is read again after a short pause.
+template <class Geometry>
+bool BasicConcurrentLedBadge<Geometry>::FetchData
+(
+    std::vector<unsigned char>& dataCopy
+) const {
+    bool    ret = false;
+    Content contents[Banks + 1];
+
+    for (size_t attempt = 0; !ret && (attempt < MaxFetchAttempts); ++attempt) {
+        if (attempt > 0) {
+            if (attempt < MaxFetchAttempts / 4)
+                std::this_thread::yield();
+            else
+                std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+
+        unsigned long long current = m_current.load(std::memory_order_acquire);
+
+        unsigned long long sequence = 0;
+
+        ret = true;
+
+        for (size_t row = 0; ret && (row <= Banks); ++row)
+            ret = Read(row, GetCurrent(current, row), contents[row], sequence);
+
+        // a version in use is not written, so the copies are of this word's point in time
+        if (ret)
+            ret = (m_current.load(std::memory_order_acquire) == current);
+    }
+
+    if (ret) {
+        BasicLedBadge<Geometry> ledBadge(m_logHandler);
+        unsigned long long      header = contents[HeaderRow].settings;
+
+        ledBadge.SetBrightness(static_cast<Brightness>(GetField(header, BrightnessField)));
+        ledBadge.SetYear(GetField(header, TimeField));
+        ledBadge.SetMonth(GetField(header, TimeField + 1));
+        ledBadge.SetDay(GetField(header, TimeField + 2));
+        ledBadge.SetHour(GetField(header, TimeField + 3));
+        ledBadge.SetMinute(GetField(header, TimeField + 4));
+        ledBadge.SetSecond(GetField(header, TimeField + 5));
+
+        for (size_t i = 0; i < Banks; ++i) {
+            typename BasicLedBadge<Geometry>::MemoryBank memoryBank = ledBadge.GetMemoryBank(i);
+            const Content&                               bank       = contents[i];
+
+            memoryBank.SetBlinking(GetField(bank.settings, BlinkingField) != 0);
+            memoryBank.SetAnimatedBorder(GetField(bank.settings, AnimatedBorderField) != 0);
+            memoryBank.SetMode(static_cast<Mode>(GetField(bank.settings, ModeField)));
+            memoryBank.SetSpeed(static_cast<Speed>(GetField(bank.settings, SpeedField)));
+            memoryBank.SetPackedData(bank.data.data(), bank.data.size());
+        }
+
+        ret = ledBadge.FetchData(dataCopy);
+    }
+    else
+        Log("Error: ConcurrentLedBadge::FetchData(): The banks changed too often to get a consistent copy\n");
+
+    return ret;
+}
+
+
+// a sequence lock read: the copy is valid if the version was not written meanwhile
+template <class Geometry>
+bool BasicConcurrentLedBadge<Geometry>::Read
+(
+    size_t              row,
+    size_t              version,
+    Content&            content,
+    unsigned long long& sequence
+) const {
+    bool           ret  = false;
+    const Version& slot = m_versions[row][version];
+
+    sequence = slot.sequence.load(std::memory_order_acquire);
+
+    if ((sequence % 2) == 0) {
+        size_t size = slot.size.load(std::memory_order_relaxed);
+
+        content.settings = slot.settings.load(std::memory_order_relaxed);
+
+        if (size <= 8 * DataWords) {
+            content.data.resize(size);
+
+            for (size_t i = 0; i < size; i += 8) {
+                unsigned long long word = slot.data[i / 8].load(std::memory_order_relaxed);
+
+                for (size_t j = i; (j < i + 8) && (j < size); ++j)
+                    content.data[j] = static_cast<unsigned char>(word >> (8 * (j - i)));
+            }
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            ret = (slot.sequence.load(std::memory_order_relaxed) == sequence);
+        }
+    }
+
+    return ret;
+}
+
+
+// the version has to be owned by the caller
+template <class Geometry>
+void BasicConcurrentLedBadge<Geometry>::Write
+(
+    size_t         row,
+    size_t         version,
+    const Content& content
+) {
+    Version&           slot     = m_versions[row][version];
+    unsigned long long sequence = slot.sequence.load(std::memory_order_relaxed);
+    size_t             size     = (row == HeaderRow) ? 0 : std::min(content.data.size(), 8 * DataWords);
+
+    slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+
+    slot.settings.store(content.settings, std::memory_order_relaxed);
+    slot.size.store(size, std::memory_order_relaxed);
+
+    for (size_t i = 0; i < size; i += 8) {
+        unsigned long long word = 0;
+
+        for (size_t j = i; (j < i + 8) && (j < size); ++j)
+            word |= static_cast<unsigned long long>(content.data[j]) << (8 * (j - i));
+
+        slot.data[i / 8].store(word, std::memory_order_relaxed);
+    }
+
+    slot.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+
+// copies the current version, changes it and publishes it in a free version,
+// starts again if the row was published by another writer meanwhile
+// The base version is the current one still if the word names it and its
+// sequence number is the copied one, a version is written before it is
+// published.
+template <class Geometry>
+void BasicConcurrentLedBadge<Geometry>::Update
+(
+    size_t                                       row,
+    const std::function<void(Content& content)>& update
+) {
+    // gives the version free on every way out
+    struct Ownership {
+        std::atomic<bool>* owned = nullptr;
+
+        ~Ownership(void) {
+            if (owned != nullptr)
+                owned->store(false, std::memory_order_release);
+        }
+    };
+
+    Content content;
+    bool    published = false;
+
+    while (!published) {
+        unsigned long long current      = m_current.load(std::memory_order_acquire);
+        size_t             base         = GetCurrent(current, row);
+        unsigned long long baseSequence = 0;
+
+        if (!Read(row, base, content, baseSequence)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        update(content);
+
+        Ownership ownership;
+        size_t    version = base;
+
+        // the oldest versions first, a slow reader may still copy the newer ones
+        for (size_t i = 1; (ownership.owned == nullptr) && (i < Versions); ++i) {
+            size_t candidate = (base + i) % Versions;
+            bool   free      = false;
+
+            if (m_versions[row][candidate].owned.compare_exchange_strong(free, true, std::memory_order_acquire)) {
+                // it may have become the current one before it was owned
+                if (GetCurrent(m_current.load(std::memory_order_acquire), row) != candidate) {
+                    ownership.owned = &m_versions[row][candidate].owned;
+                    version         = candidate;
+                }
+                else
+                    m_versions[row][candidate].owned.store(false, std::memory_order_release);
+            }
+        }
+
+        if (ownership.owned == nullptr) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        Write(row, version, content);
+
+        // other rows may be published meanwhile, then the swap is only repeated
+        while (!published &&
+               (GetCurrent(current, row) == base) &&
+               (m_versions[row][base].sequence.load(std::memory_order_acquire) == baseSequence))
+            published = m_current.compare_exchange_weak(current, Publish(current, row, version), std::memory_order_acq_rel, std::memory_order_acquire);
+    }
+}
+
+
+template <class Geometry>
+void BasicConcurrentLedBadge<Geometry>::Log
+(
+    const char* logString
+) const {
+    if (m_logHandler != nullptr)
+        (*m_logHandler)(logString);
+}
+
+
+template class BasicConcurrentLedBadge<Geometry11x44>;
+template class BasicConcurrentLedBadge<Geometry12x48>;
+template class BasicConcurrentLedBadge<Geometry16x64>;
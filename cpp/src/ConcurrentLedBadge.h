@@ -0,0 +1,137 @@
+/*               C O N C U R R E N T L E D B A D G E . H
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef CONCURRENTLEDBADGE_INCLUDED
+#define CONCURRENTLEDBADGE_INCLUDED
+
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "LedBadge.h"
+
+
+// a badge whose banks can be set from several threads at once
+// Every bank and the header have a few versions, each guarded by a sequence
+// number.  An update writes a version which is not in use and publishes it
+// with a compare and swap on one word holding the current version of every
+// bank and the header and a generation count, so FetchData() gets the state
+// of one point in time by reading that word.  It copies the versions without
+// locking and retries if the word changed or a writer reused a version
+// meanwhile.  More than Versions - 1 concurrent updates of
+// the same bank wait for a free version.
+
+template <class Geometry = Geometry11x44>
+class BasicConcurrentLedBadge : public LedBadgeBase {
+public:
+    static constexpr size_t Rows         = Geometry::Rows;
+    static constexpr size_t DisplayWidth = Geometry::DisplayWidth;
+    static constexpr size_t Banks        = Geometry::Banks;
+
+    BasicConcurrentLedBadge(std::function<void(const char* logString)>* logHandler = nullptr);
+    ~BasicConcurrentLedBadge(void);
+
+    class MemoryBank {
+    public:
+        MemoryBank(const MemoryBank& original);
+        ~MemoryBank(void);
+
+        MemoryBank& operator=(const MemoryBank& original);
+
+        void SetBlinking(bool on);
+        void SetAnimatedBorder(bool on);
+        void SetMode(Mode value);
+        void SetSpeed(Speed value);
+        bool SetData(size_t                                         length,
+                     const std::function<bool(size_t x, size_t y)>& ledOn);
+        // already encoded data, Rows bytes per 8 columns
+        bool SetPackedData(const unsigned char* data,
+                           size_t               size);
+
+    private:
+        MemoryBank(BasicConcurrentLedBadge* parent,
+                   size_t                   index);
+
+        BasicConcurrentLedBadge* m_parent;
+        size_t                   m_index;
+
+        friend BasicConcurrentLedBadge;
+
+        MemoryBank(void); // not implemented
+    };
+
+    void       SetBrightness(Brightness value);
+    MemoryBank GetMemoryBank(size_t index);
+    void       SetYear(unsigned char value);
+    void       SetMonth(unsigned char value);
+    void       SetDay(unsigned char value);
+    void       SetHour(unsigned char value);
+    void       SetMinute(unsigned char value);
+    void       SetSecond(unsigned char value);
+
+    bool       FetchData(std::vector<unsigned char>& dataCopy) const;
+
+private:
+    static const size_t Versions         = 4; // per bank, the current one included
+    static const size_t HeaderRow        = Banks;
+    static const size_t DataWords        = (Geometry::MaxSize - Geometry::HeaderSize + 7) / 8;
+    static const size_t MaxFetchAttempts = 64;
+
+    // one version of a bank or the header, the bank data is packed into words
+    // to be copied with atomic operations
+    struct Version {
+        std::atomic<unsigned long long>                    sequence; // odd while the version is written
+        std::atomic<bool>                                  owned;    // by a writer
+        std::atomic<unsigned long long>                    settings;
+        std::atomic<size_t>                                size;     // of the data in bytes
+        std::unique_ptr<std::atomic<unsigned long long>[]> data;
+    };
+
+    struct Content {
+        unsigned long long         settings;
+        std::vector<unsigned char> data;
+    };
+
+    std::function<void(const char* logString)>* m_logHandler;
+    Version                                     m_versions[Banks + 1][Versions]; // the last row is the header
+    std::atomic<unsigned long long>             m_current;                       // 2 bits per row and the generation
+
+    bool Read(size_t              row,
+              size_t              version,
+              Content&            content,
+              unsigned long long& sequence) const;
+    void Write(size_t         row,
+               size_t         version,
+               const Content& content);
+    void Update(size_t                                       row,
+                const std::function<void(Content& content)>& update);
+    void Log(const char* logString) const;
+
+    friend MemoryBank;
+
+    BasicConcurrentLedBadge(const BasicConcurrentLedBadge&);            // not implemented
+    BasicConcurrentLedBadge& operator=(const BasicConcurrentLedBadge&); // not implemented
+};
+
+
+extern template class BasicConcurrentLedBadge<Geometry11x44>;
+extern template class BasicConcurrentLedBadge<Geometry12x48>;
+extern template class BasicConcurrentLedBadge<Geometry16x64>;
+
+
+typedef BasicConcurrentLedBadge<> ConcurrentLedBadge;
+
+
+#endif // CONCURRENTLEDBADGE_INCLUDED
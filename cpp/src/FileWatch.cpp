@@ -0,0 +1,429 @@
+/*                      F I L E W A T C H . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include "FileWatch.h"
+
+
+// a burst of changes is sent after this time at the latest
+static const int MaxDebounceFactor = 5;
+
+
+static bool ReadFile
+(
+    const std::string&          fileName,
+    std::vector<unsigned char>& data
+) {
+    std::ifstream file(fileName, std::ios::binary);
+    bool          ret = false;
+
+    if (file) {
+        data.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        ret = !file.bad();
+    }
+
+    return ret;
+}
+
+
+// the next number in a PBM header, comments are skipped
+static bool ReadPbmNumber
+(
+    const std::vector<unsigned char>& data,
+    size_t&                           position,
+    size_t&                           value
+) {
+    bool ret = false;
+
+    while (position < data.size()) {
+        if (data[position] == '#') {
+            while ((position < data.size()) && (data[position] != '\n'))
+                ++position;
+        }
+        else if (isspace(data[position]))
+            ++position;
+        else
+            break;
+    }
+
+    value = 0;
+
+    while ((position < data.size()) && isdigit(data[position])) {
+        value = value * 10 + (data[position] - '0');
+        ++position;
+        ret   = true;
+    }
+
+    return ret;
+}
+
+
+FileWatch::FileWatch
+(
+    std::function<void(const char* logString)>* logHandler
+) : m_logHandler(logHandler), m_updateHandler(nullptr), m_debounce(100), m_sources(), m_ledBadge(logHandler),
+    m_stopEvent(eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC)) {}
+
+
+FileWatch::~FileWatch(void) {
+    if (m_stopEvent >= 0)
+        close(m_stopEvent);
+}
+
+
+void FileWatch::SetUpdateHandler
+(
+    std::function<void(const FileWatchUpdate& update)>* updateHandler
+) {
+    m_updateHandler = updateHandler;
+}
+
+
+void FileWatch::SetDebounce
+(
+    std::chrono::milliseconds debounce
+) {
+    m_debounce = debounce;
+}
+
+
+bool FileWatch::AddSource
+(
+    size_t             index,
+    const std::string& fileName,
+    const Loader&      loader
+) {
+    bool ret = false;
+
+    if ((index < LedBadge::Banks) && !fileName.empty() && loader) {
+        Source source;
+        size_t separator = fileName.rfind('/');
+
+        source.index  = index;
+        source.loader = loader;
+
+        if (separator == std::string::npos) {
+            source.directory = ".";
+            source.name      = fileName;
+        }
+        else {
+            source.directory = (separator == 0) ? "/" : fileName.substr(0, separator);
+            source.name      = fileName.substr(separator + 1);
+        }
+
+        m_sources.push_back(source);
+        ret = true;
+    }
+    else
+        Log("Error: FileWatch::AddSource(): Invalid bank or file\n");
+
+    return ret;
+}
+
+
+LedBadge& FileWatch::GetLedBadge(void) {
+    return m_ledBadge;
+}
+
+
+bool FileWatch::Run
+(
+    const UsbTransferOptions& options
+) {
+    bool ret = false;
+    int  fd  = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if (m_sources.size() == 0)
+        Log("Error: FileWatch::Run(): No files to watch\n");
+    else if ((fd < 0) || (m_stopEvent < 0))
+        Log("Error: FileWatch::Run(): Cannot create the inotify instance\n");
+    else {
+        // by source, a directory given in several spellings has one watch descriptor
+        std::vector<int> watches(m_sources.size(), -1);
+
+        ret = true;
+
+        for (size_t i = 0; i < m_sources.size(); ++i) {
+            const Source& source = m_sources[i];
+            int           watch  = inotify_add_watch(fd, source.directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+
+            if (watch >= 0)
+                watches[i] = watch;
+            else {
+                std::stringstream logstream;
+                logstream << "Error: FileWatch::Run(): Cannot watch " << source.directory << ": " << strerror(errno) << "\n";
+                Log(logstream.str().c_str());
+                ret = false;
+            }
+        }
+
+        if (ret) {
+            FileWatchUpdate update;
+            pollfd          stopEvent = {m_stopEvent, POLLIN, 0};
+            bool            stopped   = (poll(&stopEvent, 1, 0) == 1); // a Stop() before the Run()
+
+            if (!stopped && Load(std::vector<bool>(m_sources.size(), true), update))
+                Send(options, std::chrono::steady_clock::now(), update);
+
+            std::vector<bool>                     changed(m_sources.size(), false);
+            bool                                  pending     = false;
+            std::chrono::steady_clock::time_point firstChange;
+            std::chrono::steady_clock::time_point lastChange;
+            std::chrono::steady_clock::time_point deadline;
+
+            while (!stopped) {
+                int timeout = -1;
+
+                // rounded up, so the poll() does not return before the deadline
+                if (pending)
+                    timeout = static_cast<int>(std::max<long long>(std::chrono::ceil<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now()).count(), 0));
+
+                pollfd descriptors[2] = {{fd, POLLIN, 0}, {m_stopEvent, POLLIN, 0}};
+                int    ready          = poll(descriptors, 2, timeout);
+
+                if (ready < 0) {
+                    if (errno != EINTR) {
+                        Log("Error: FileWatch::Run(): poll() failed\n");
+                        ret     = false;
+                        stopped = true;
+                    }
+                }
+                else if (descriptors[1].revents != 0)
+                    stopped = true;
+                else if (descriptors[0].revents != 0) {
+                    // the buffer is aligned for the events
+                    alignas(inotify_event) char buffer[4096];
+                    ssize_t                     size    = 0;
+                    bool                        matched = false;
+
+                    while ((size = read(fd, buffer, sizeof(buffer))) > 0) {
+                        for (ssize_t offset = 0; offset < size;) {
+                            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+
+                            if ((event->mask & IN_Q_OVERFLOW) != 0) {
+                                changed.assign(m_sources.size(), true);
+                                matched = true;
+                            }
+                            else if (event->len > 0) {
+                                for (size_t i = 0; i < m_sources.size(); ++i) {
+                                    if ((watches[i] == event->wd) && (m_sources[i].name == event->name)) {
+                                        changed[i] = true;
+                                        matched    = true;
+                                    }
+                                }
+                            }
+
+                            offset += sizeof(inotify_event) + event->len;
+                        }
+                    }
+
+                    // events of other files in the directories do not delay the update
+                    if (matched) {
+                        lastChange = std::chrono::steady_clock::now();
+
+                        if (!pending) {
+                            firstChange = lastChange;
+                            pending     = true;
+                        }
+
+                        deadline = std::min(lastChange + m_debounce, firstChange + MaxDebounceFactor * m_debounce);
+                    }
+                }
+
+                // also while events of other files keep the poll() from timing out
+                if (!stopped && pending && (std::chrono::steady_clock::now() >= deadline)) {
+                    update = FileWatchUpdate();
+
+                    if (Load(changed, update))
+                        Send(options, firstChange, update);
+
+                    changed.assign(m_sources.size(), false);
+                    pending = false;
+                }
+            }
+
+            if (stopped) {
+                eventfd_t stopCount = 0;
+
+                eventfd_read(m_stopEvent, &stopCount); // the next Run() starts again
+            }
+        }
+    }
+
+    if (fd >= 0)
+        close(fd);
+
+    return ret;
+}
+
+
+void FileWatch::Stop(void) {
+    eventfd_write(m_stopEvent, 1);
+}
+
+
+bool FileWatch::LoadBitmap
+(
+    const std::string&   fileName,
+    size_t               /* index */,
+    LedBadge::MemoryBank memoryBank
+) {
+    bool                       ret = false;
+    std::vector<unsigned char> data;
+    size_t                     position = 2;
+    size_t                     width    = 0;
+    size_t                     height   = 0;
+
+    if (ReadFile(fileName, data) && (data.size() > 2) && (data[0] == 'P') && ((data[1] == '1') || (data[1] == '4')) &&
+        ReadPbmNumber(data, position, width) && ReadPbmNumber(data, position, height) && (height == LedBadge::Rows)) {
+        std::vector<bool> pixels(width * height, false);
+
+        if (data[1] == '1') {
+            size_t i = 0;
+
+            for (; (position < data.size()) && (i < pixels.size()); ++position) {
+                if ((data[position] == '0') || (data[position] == '1'))
+                    pixels[i++] = (data[position] == '1');
+            }
+
+            ret = (i == pixels.size());
+        }
+        else {
+            size_t rowSize = (width + 7) / 8;
+
+            ++position; // the single white space behind the height
+
+            if (position + rowSize * height <= data.size()) {
+                for (size_t y = 0; y < height; ++y) {
+                    for (size_t x = 0; x < width; ++x)
+                        pixels[y * width + x] = ((data[position + y * rowSize + x / 8] >> (7 - x % 8)) & 1) != 0;
+                }
+
+                ret = true;
+            }
+        }
+
+        if (ret)
+            ret = memoryBank.SetData(width, [&pixels, width](size_t x, size_t y) {return pixels[y * width + x];});
+    }
+
+    return ret;
+}
+
+
+bool FileWatch::LoadPackedData
+(
+    const std::string&   fileName,
+    size_t               index,
+    LedBadge::MemoryBank memoryBank
+) {
+    bool                       ret = false;
+    std::vector<unsigned char> data;
+
+    if (ReadFile(fileName, data)) {
+        size_t bankOffset = 0;
+        size_t bankSize   = data.size();
+
+        if ((data.size() >= 4) && (memcmp(data.data(), "wang", 4) == 0))
+            ret = LedBadge::FindBankData(data.data(), data.size(), index, bankOffset, bankSize);
+        else
+            ret = true;
+
+        if (ret)
+            ret = memoryBank.SetPackedData(data.data() + bankOffset, bankSize);
+    }
+
+    return ret;
+}
+
+
+bool FileWatch::Load
+(
+    const std::vector<bool>& changed,
+    FileWatchUpdate&         update
+) {
+    for (size_t i = 0; i < m_sources.size(); ++i) {
+        if (changed[i]) {
+            const Source& source   = m_sources[i];
+            std::string   fileName = source.directory + "/" + source.name;
+
+            if (source.loader(fileName, source.index, m_ledBadge.GetMemoryBank(source.index))) {
+                if (std::find(update.banks.begin(), update.banks.end(), source.index) == update.banks.end())
+                    update.banks.push_back(source.index);
+            }
+            else {
+                std::stringstream logstream;
+                logstream << "Warning: FileWatch: Cannot load " << fileName << ", bank " << (source.index + 1) << " is kept\n";
+                Log(logstream.str().c_str());
+            }
+        }
+    }
+
+    std::sort(update.banks.begin(), update.banks.end());
+
+    return (update.banks.size() > 0);
+}
+
+
+bool FileWatch::Send
+(
+    const UsbTransferOptions&             options,
+    std::chrono::steady_clock::time_point firstChange,
+    FileWatchUpdate&                      update
+) {
+    std::vector<unsigned char> data;
+    UsbTransferOptions         sendOptions = options;
+
+    sendOptions.synchronizeClock = true;
+
+    if (m_ledBadge.FetchData(data))
+        update.success = SendToUsb(data, m_logHandler, &update.statistics, sendOptions);
+
+    update.latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - firstChange).count();
+
+    std::stringstream logstream;
+    logstream << (update.success ? "Info" : "Warning") << ": FileWatch: Bank";
+
+    for (size_t i = 0; i < update.banks.size(); ++i)
+        logstream << ((i == 0) ? " " : ", ") << (update.banks[i] + 1);
+
+    logstream << (update.success ? " on the badge " : " not sent, ") << update.latency << " s after the change\n";
+    Log(logstream.str().c_str());
+
+    if (m_updateHandler != nullptr)
+        (*m_updateHandler)(update);
+
+    return update.success;
+}
+
+
+void FileWatch::Log
+(
+    const char* logString
+) const {
+    if (m_logHandler != nullptr)
+        (*m_logHandler)(logString);
+}
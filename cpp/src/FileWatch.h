@@ -0,0 +1,95 @@
+/*                        F I L E W A T C H . H
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef FILEWATCH_INCLUDED
+#define FILEWATCH_INCLUDED
+
+#include <chrono>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "LedBadge.h"
+#include "usb.h"
+
+
+struct FileWatchUpdate {
+    std::vector<size_t>   banks;         // reloaded
+    double                latency = 0.;  // in s, from the first change to the end of the upload
+    bool                  success = false;
+    UsbTransferStatistics statistics;
+};
+
+
+// loads files into memory banks and sends the badge again when they change
+// The directories of the files are watched with inotify, so files which are
+// replaced by a rename are seen too.  Changes are collected until the files
+// are quiet for the debounce time, then only the banks of the changed files
+// are loaded again.  Linux only.
+class FileWatch {
+public:
+    typedef std::function<bool(const std::string& fileName, size_t index, LedBadge::MemoryBank memoryBank)> Loader;
+
+    FileWatch(std::function<void(const char* logString)>* logHandler = nullptr);
+    ~FileWatch(void);
+
+    void      SetUpdateHandler(std::function<void(const FileWatchUpdate& update)>* updateHandler);
+    void      SetDebounce(std::chrono::milliseconds debounce);
+    bool      AddSource(size_t             index,
+                        const std::string& fileName,
+                        const Loader&      loader);
+    LedBadge& GetLedBadge(void); // for the settings, before Run()
+
+    // sends all banks once and then on every change until Stop()
+    bool      Run(const UsbTransferOptions& options = UsbTransferOptions());
+    void      Stop(void); // may be called from a signal handler
+
+    // bitmaps in the PBM format (P1 or P4), the height has to be LedBadge::Rows
+    static bool LoadBitmap(const std::string&   fileName,
+                           size_t               index,
+                           LedBadge::MemoryBank memoryBank);
+    // payloads as exported by the designer: the bank with the same index,
+    // other files: packed bank data, LedBadge::Rows bytes per 8 columns
+    static bool LoadPackedData(const std::string&   fileName,
+                               size_t               index,
+                               LedBadge::MemoryBank memoryBank);
+
+private:
+    struct Source {
+        size_t      index;
+        std::string directory;
+        std::string name;
+        Loader      loader;
+    };
+
+    std::function<void(const char* logString)>*          m_logHandler;
+    std::function<void(const FileWatchUpdate& update)>*  m_updateHandler;
+    std::chrono::milliseconds                            m_debounce;
+    std::vector<Source>                                  m_sources;
+    LedBadge                                             m_ledBadge;
+    int                                                  m_stopEvent;
+
+    bool Load(const std::vector<bool>& changed,
+              FileWatchUpdate&         update);
+    bool Send(const UsbTransferOptions&             options,
+              std::chrono::steady_clock::time_point firstChange,
+              FileWatchUpdate&                      update);
+    void Log(const char* logString) const;
+
+    FileWatch(const FileWatch&);            // not implemented
+    FileWatch& operator=(const FileWatch&); // not implemented
+};
+
+
+#endif // FILEWATCH_INCLUDED
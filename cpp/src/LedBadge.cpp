@@ -12,8 +12,10 @@
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <algorithm>
 #include <cassert>
 #include <cstring>
+#include <string>
 
 #include "LedBadge.h"
 
@@ -39,11 +41,12 @@ static inline void SetHigherBits(unsigned char& byte,
 }
 
 
-LedBadge::LedBadge
+template <class Geometry>
+BasicLedBadge<Geometry>::BasicLedBadge
 (
     std::function<void(const char* logString)>* logHandler
 ) : m_logHandler(logHandler), m_bankData() {
-    static const unsigned char NullHeader[m_HeaderSize] = {
+    static const unsigned char NullHeader[64] = {
         '\x77', '\x61', '\x6e', '\x67', '\x00', // [0-4]: "wang"
         '\x00',                                 // [5]  : brightness (full), 0x00 = 100% / 0x10 = 75% / 0x20 = 50% / 0x40 = 25%
         '\x00',                                 // [6]  : blinking (no), 1 bit per memory bank
@@ -82,32 +85,36 @@ LedBadge::LedBadge
         '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00', '\x00' // [44-63]
     };
 
-    memcpy(m_header, NullHeader, m_HeaderSize);
+    memset(m_header, 0, m_HeaderSize);
+    memcpy(m_header, NullHeader, sizeof(NullHeader));
 }
 
 
-LedBadge::LedBadge
+template <class Geometry>
+BasicLedBadge<Geometry>::BasicLedBadge
 (
-    const LedBadge& original
+    const BasicLedBadge& original
 ) : m_logHandler(original.m_logHandler), m_bankData() {
     memcpy(m_header, original.m_header, m_HeaderSize);
 
-    for (size_t i = 0; i < 8; ++i)
+    for (size_t i = 0; i < Banks; ++i)
         m_bankData[i] = original.m_bankData[i];
 }
 
 
-LedBadge::~LedBadge(void) {}
+template <class Geometry>
+BasicLedBadge<Geometry>::~BasicLedBadge(void) {}
 
 
-LedBadge& LedBadge::operator=
+template <class Geometry>
+BasicLedBadge<Geometry>& BasicLedBadge<Geometry>::operator=
 (
-    const LedBadge& original
+    const BasicLedBadge& original
 ) {
     if (this != &original) {
         memcpy(m_header, original.m_header, m_HeaderSize);
 
-        for (size_t i = 0; i < 8; ++i)
+        for (size_t i = 0; i < Banks; ++i)
             m_bankData[i] = original.m_bankData[i];
     }
 
@@ -115,19 +122,31 @@ LedBadge& LedBadge::operator=
 }
 
 
-LedBadge::MemoryBank::MemoryBank
+template <class Geometry>
+void BasicLedBadge<Geometry>::SetLogHandler
+(
+    std::function<void(const char* logString)>* logHandler
+) {
+    m_logHandler = logHandler;
+}
+
+
+template <class Geometry>
+BasicLedBadge<Geometry>::MemoryBank::MemoryBank
 (
     const MemoryBank& original
 ) : m_parent(original.m_parent), m_index(original.m_index) {
     assert(m_parent != nullptr);
-    assert(m_index < 8);
+    assert(m_index < Banks);
 }
 
 
-LedBadge::MemoryBank::~MemoryBank(void) {}
+template <class Geometry>
+BasicLedBadge<Geometry>::MemoryBank::~MemoryBank(void) {}
 
 
-LedBadge::MemoryBank& LedBadge::MemoryBank::operator=
+template <class Geometry>
+typename BasicLedBadge<Geometry>::MemoryBank& BasicLedBadge<Geometry>::MemoryBank::operator=
 (
     const MemoryBank& original
 ) {
@@ -137,129 +156,134 @@ LedBadge::MemoryBank& LedBadge::MemoryBank::operator=
     }
 
     assert(m_parent != nullptr);
-    assert(m_index < 8);
+    assert(m_index < Banks);
 
     return *this;
 }
 
 
-void LedBadge::MemoryBank::SetBlinking
+template <class Geometry>
+void BasicLedBadge<Geometry>::MemoryBank::SetBlinking
 (
     bool on
 ) {
-    if ((m_parent != nullptr) && (m_index < 8))
-        SetBit(m_parent->m_header[6], m_index, on);
+    if ((m_parent != nullptr) && (m_index < Banks))
+        SetBit(m_parent->m_header[m_BlinkingOffset], m_index, on);
 }
 
 
-void LedBadge::MemoryBank::SetAnimatedBorder
+template <class Geometry>
+void BasicLedBadge<Geometry>::MemoryBank::SetAnimatedBorder
 (
     bool on
 ) {
-    if ((m_parent != nullptr) && (m_index < 8))
-        SetBit(m_parent->m_header[7], m_index, on);
+    if ((m_parent != nullptr) && (m_index < Banks))
+        SetBit(m_parent->m_header[m_AnimatedBorderOffset], m_index, on);
 }
 
 
-void LedBadge::MemoryBank::SetMode
+template <class Geometry>
+void BasicLedBadge<Geometry>::MemoryBank::SetMode
 (
     Mode value
 ) {
-    if ((m_parent != nullptr) && (m_index < 8)) {
+    if ((m_parent != nullptr) && (m_index < Banks)) {
         switch (value) {
             case Mode::LeftScroll:
-                SetLowerBits(m_parent->m_header[8 + m_index], '\x00');
+                SetLowerBits(m_parent->m_header[m_ModeOffset + m_index], '\x00');
                 break;
 
             case Mode::RightScroll:
-                SetLowerBits(m_parent->m_header[8 + m_index], '\x01');
+                SetLowerBits(m_parent->m_header[m_ModeOffset + m_index], '\x01');
                 break;
 
             case Mode::UpScroll:
-                SetLowerBits(m_parent->m_header[8 + m_index], '\x02');
+                SetLowerBits(m_parent->m_header[m_ModeOffset + m_index], '\x02');
                 break;
 
             case Mode::DownScroll:
-                SetLowerBits(m_parent->m_header[8 + m_index], '\x03');
+                SetLowerBits(m_parent->m_header[m_ModeOffset + m_index], '\x03');
                 break;
 
             case Mode::Centered:
-                SetLowerBits(m_parent->m_header[8 + m_index], '\x04');
+                SetLowerBits(m_parent->m_header[m_ModeOffset + m_index], '\x04');
                 break;
 
             case Mode::Snowflake:
-                SetLowerBits(m_parent->m_header[8 + m_index], '\x05');
+                SetLowerBits(m_parent->m_header[m_ModeOffset + m_index], '\x05');
                 break;
 
             case Mode::DropDown:
-                SetLowerBits(m_parent->m_header[8 + m_index], '\x06');
+                SetLowerBits(m_parent->m_header[m_ModeOffset + m_index], '\x06');
                 break;
 
             case Mode::Curtain:
-                SetLowerBits(m_parent->m_header[8 + m_index], '\x07');
+                SetLowerBits(m_parent->m_header[m_ModeOffset + m_index], '\x07');
                 break;
 
             case Mode::Laser:
-                SetLowerBits(m_parent->m_header[8 + m_index], '\x08');
+                SetLowerBits(m_parent->m_header[m_ModeOffset + m_index], '\x08');
         }
     }
 }
 
 
-void LedBadge::MemoryBank::SetSpeed
+template <class Geometry>
+void BasicLedBadge<Geometry>::MemoryBank::SetSpeed
 (
     Speed value
 ) {
-    if ((m_parent != nullptr) && (m_index < 8)) {
+    if ((m_parent != nullptr) && (m_index < Banks)) {
         switch (value) {
             case Speed::One:
-                SetHigherBits(m_parent->m_header[8 + m_index], '\x00');
+                SetHigherBits(m_parent->m_header[m_ModeOffset + m_index], '\x00');
                 break;
 
             case Speed::Two:
-                SetHigherBits(m_parent->m_header[8 + m_index], '\x10');
+                SetHigherBits(m_parent->m_header[m_ModeOffset + m_index], '\x10');
                 break;
 
             case Speed::Three:
-                SetHigherBits(m_parent->m_header[8 + m_index], '\x20');
+                SetHigherBits(m_parent->m_header[m_ModeOffset + m_index], '\x20');
                 break;
 
             case Speed::Four:
-                SetHigherBits(m_parent->m_header[8 + m_index], '\x30');
+                SetHigherBits(m_parent->m_header[m_ModeOffset + m_index], '\x30');
                 break;
 
             case Speed::Five:
-                SetHigherBits(m_parent->m_header[8 + m_index], '\x40');
+                SetHigherBits(m_parent->m_header[m_ModeOffset + m_index], '\x40');
                 break;
 
             case Speed::Six:
-                SetHigherBits(m_parent->m_header[8 + m_index], '\x50');
+                SetHigherBits(m_parent->m_header[m_ModeOffset + m_index], '\x50');
                 break;
 
             case Speed::Seven:
-                SetHigherBits(m_parent->m_header[8 + m_index], '\x60');
+                SetHigherBits(m_parent->m_header[m_ModeOffset + m_index], '\x60');
                 break;
 
             case Speed::Eight:
-                SetHigherBits(m_parent->m_header[8 + m_index], '\x70');
+                SetHigherBits(m_parent->m_header[m_ModeOffset + m_index], '\x70');
         }
     }
 }
 
 
-bool LedBadge::MemoryBank::SetData
+template <class Geometry>
+bool BasicLedBadge<Geometry>::MemoryBank::SetData
 (
     size_t                                         length,
     const std::function<bool(size_t x, size_t y)>& ledOn
 ) {
     bool ret = true;
 
-    if ((m_parent != nullptr) && (m_index < 8)) {
+    if ((m_parent != nullptr) && (m_index < Banks)) {
         // get real length
         for (; length > 0; --length) {
             bool rowEmpty = true;
 
-            for (size_t i = 0; i < 11; ++i) {
+            for (size_t i = 0; i < Rows; ++i) {
                 if (ledOn(length - 1, i)) {
                     rowEmpty = false;
                     break;
@@ -275,11 +299,11 @@ bool LedBadge::MemoryBank::SetData
         if (length > 0) {
             size_t lengthInBytes = (length - 1) / 8 + 1;
 
-            if (lengthInBytes <= ((m_MaxSize - m_HeaderSize) / 11)) {
-                bankData.resize(11 * lengthInBytes);
+            if (lengthInBytes <= ((m_MaxSize - m_HeaderSize) / Rows)) {
+                bankData.resize(Rows * lengthInBytes);
 
                 for (size_t byteColumn = 0; byteColumn < lengthInBytes; ++byteColumn) {
-                    for (size_t byteRow = 0; byteRow < 11; ++byteRow) {
+                    for (size_t byteRow = 0; byteRow < Rows; ++byteRow) {
                         unsigned char byte = '\x00';
 
                         for (size_t byteDigit = 0; byteDigit < 8; ++byteDigit) {
@@ -292,23 +316,80 @@ bool LedBadge::MemoryBank::SetData
                             SetBit(byte, 7 - byteDigit, pixel);
                         }
 
-                        bankData[11 * byteColumn + byteRow] = byte;
+                        bankData[Rows * byteColumn + byteRow] = byte;
                     }
                 }
 
-                m_parent->m_header[16 + 2 * m_index]     = lengthInBytes / 256;
-                m_parent->m_header[16 + 2 * m_index + 1] = lengthInBytes % 256;
+                m_parent->m_header[m_LengthOffset + 2 * m_index]     = lengthInBytes / 256;
+                m_parent->m_header[m_LengthOffset + 2 * m_index + 1] = lengthInBytes % 256;
             }
             else {
-                m_parent->Log("Error: LedBadge::MemoryBank::SetData(): Data size to hight, max length for all banks together is 5904 pixel\n");
+                static const std::string message = "Error: LedBadge::MemoryBank::SetData(): Data size to hight, max length for all banks together is "
+                                                   + std::to_string((m_MaxSize - m_HeaderSize) / Rows * 8) + " pixel\n";
+
+                m_parent->Log(message.c_str());
                 ret = false;
             }
         }
         else  if (bankData.size() > 0) {
             bankData.clear();
 
-            m_parent->m_header[16 + 2 * m_index]     = '\x00';
-            m_parent->m_header[16 + 2 * m_index + 1] = '\x00';
+            m_parent->m_header[m_LengthOffset + 2 * m_index]     = '\x00';
+            m_parent->m_header[m_LengthOffset + 2 * m_index + 1] = '\x00';
+        }
+    }
+
+    return ret;
+}
+
+
+template <class Geometry>
+bool BasicLedBadge<Geometry>::MemoryBank::SetPackedData
+(
+    const unsigned char* data,
+    size_t               size
+) {
+    bool ret = true;
+
+    if ((m_parent != nullptr) && (m_index < Banks)) {
+        if (((data == nullptr) && (size > 0)) || ((size % Rows) != 0)) {
+            static const std::string message = "Error: LedBadge::MemoryBank::SetPackedData(): Data size has to be a multiple of "
+                                               + std::to_string(Rows) + " bytes\n";
+
+            m_parent->Log(message.c_str());
+            ret = false;
+        }
+        else {
+            // get real length
+            for (; size > 0; size -= Rows) {
+                bool byteColumnEmpty = true;
+
+                for (size_t i = size - Rows; i < size; ++i) {
+                    if (data[i] != '\x00') {
+                        byteColumnEmpty = false;
+                        break;
+                    }
+                }
+
+                if (!byteColumnEmpty)
+                    break;
+            }
+
+            size_t lengthInBytes = size / Rows;
+
+            if (lengthInBytes <= ((m_MaxSize - m_HeaderSize) / Rows)) {
+                m_parent->m_bankData[m_index].assign(data, data + size);
+
+                m_parent->m_header[m_LengthOffset + 2 * m_index]     = lengthInBytes / 256;
+                m_parent->m_header[m_LengthOffset + 2 * m_index + 1] = lengthInBytes % 256;
+            }
+            else {
+                static const std::string message = "Error: LedBadge::MemoryBank::SetPackedData(): Data size to hight, max length for all banks together is "
+                                                   + std::to_string((m_MaxSize - m_HeaderSize) / Rows * 8) + " pixel\n";
+
+                m_parent->Log(message.c_str());
+                ret = false;
+            }
         }
     }
 
@@ -316,104 +397,115 @@ bool LedBadge::MemoryBank::SetData
 }
 
 
-LedBadge::MemoryBank::MemoryBank
+template <class Geometry>
+BasicLedBadge<Geometry>::MemoryBank::MemoryBank
 (
-    LedBadge* parent,
-    size_t    index
+    BasicLedBadge* parent,
+    size_t         index
 ) : m_parent(parent), m_index(index) {
     assert(m_parent != nullptr);
-    assert(m_index < 8);
+    assert(m_index < Banks);
 }
 
 
-void LedBadge::SetBrightness
+template <class Geometry>
+void BasicLedBadge<Geometry>::SetBrightness
 (
     Brightness value
 ) {
     switch (value) {
         case Brightness::Full:
-            m_header[5] = '\x00';
+            m_header[m_BrightnessOffset] = '\x00';
             break;
 
         case Brightness::High:
-            m_header[5] = '\x10';
+            m_header[m_BrightnessOffset] = '\x10';
             break;
 
         case Brightness::Medium:
-            m_header[5] = '\x20';
+            m_header[m_BrightnessOffset] = '\x20';
             break;
 
         case Brightness::Low:
-            m_header[5] = '\x40';
+            m_header[m_BrightnessOffset] = '\x40';
     }
 }
 
 
-LedBadge::MemoryBank LedBadge::GetMemoryBank
+template <class Geometry>
+typename BasicLedBadge<Geometry>::MemoryBank BasicLedBadge<Geometry>::GetMemoryBank
 (
     size_t index
 ) {
-    assert(index < 8);
+    assert(index < Banks);
 
     return MemoryBank(this, index);
 }
 
-void LedBadge::SetYear
+
+template <class Geometry>
+void BasicLedBadge<Geometry>::SetYear
 (
     unsigned char value
 ) {
-    m_header[38] = value;
+    m_header[m_TimeOffset + 0] = value;
 }
 
 
-void LedBadge::SetMonth
+template <class Geometry>
+void BasicLedBadge<Geometry>::SetMonth
 (
     unsigned char value
 ) {
-    m_header[39] = value;
+    m_header[m_TimeOffset + 1] = value;
 }
 
 
-void LedBadge::SetDay
+template <class Geometry>
+void BasicLedBadge<Geometry>::SetDay
 (
     unsigned char value
 ) {
-    m_header[40] = value;
+    m_header[m_TimeOffset + 2] = value;
 }
 
 
-void LedBadge::SetHour
+template <class Geometry>
+void BasicLedBadge<Geometry>::SetHour
 (
     unsigned char value
 ) {
-    m_header[41] = value;
+    m_header[m_TimeOffset + 3] = value;
 }
 
 
-void LedBadge::SetMinute
+template <class Geometry>
+void BasicLedBadge<Geometry>::SetMinute
 (
     unsigned char value
 ) {
-    m_header[42] = value;
+    m_header[m_TimeOffset + 4] = value;
 }
 
 
-void LedBadge::SetSecond
+template <class Geometry>
+void BasicLedBadge<Geometry>::SetSecond
 (
     unsigned char value
 ) {
-    m_header[43] = value;
+    m_header[m_TimeOffset + 5] = value;
 }
 
 
-bool LedBadge::FetchData
+template <class Geometry>
+bool BasicLedBadge<Geometry>::FetchData
 (
     std::vector<unsigned char>& dataCopy
 ) const {
     bool   ret      = false;
     size_t dataSize = m_HeaderSize;
 
-    for (size_t i = 0; i < 8; ++i)
+    for (size_t i = 0; i < Banks; ++i)
         dataSize += m_bankData[i].size();
 
     if (dataSize <= m_MaxSize) {
@@ -423,22 +515,124 @@ bool LedBadge::FetchData
         for (size_t i = 0; i < m_HeaderSize; ++i)
             dataCopy.push_back(m_header[i]);
 
-        for (size_t i = 0; i < 8; ++i)
+        for (size_t i = 0; i < Banks; ++i)
             dataCopy.insert(dataCopy.end(), m_bankData[i].begin(), m_bankData[i].end());
 
         ret = true;
     }
-    else
-        Log("Error: LedBadge::FetchData(): Data size to hight, max is 8192 bytes, try to reduce the bank data\n");
+    else {
+        static const std::string message = "Error: LedBadge::FetchData(): Data size to hight, max is " + std::to_string(m_MaxSize)
+                                           + " bytes, try to reduce the bank data\n";
+
+        Log(message.c_str());
+    }
 
     return ret;
 }
 
 
-void LedBadge::Log
+template <class Geometry>
+bool BasicLedBadge<Geometry>::FetchData
+(
+    unsigned char* data,
+    size_t         capacity,
+    size_t&        size
+) const {
+    bool ret = false;
+
+    size = m_HeaderSize;
+
+    for (size_t i = 0; i < Banks; ++i)
+        size += m_bankData[i].size();
+
+    if (size > m_MaxSize) {
+        static const std::string message = "Error: LedBadge::FetchData(): Data size to hight, max is " + std::to_string(m_MaxSize)
+                                           + " bytes, try to reduce the bank data\n";
+
+        Log(message.c_str());
+    }
+    else if ((data == nullptr) || (capacity < size)) {
+        if (data != nullptr) // else a size query
+            Log("Error: LedBadge::FetchData(): Buffer too small\n");
+    }
+    else {
+        memcpy(data, m_header, m_HeaderSize);
+        data += m_HeaderSize;
+
+        for (size_t i = 0; i < Banks; ++i) {
+            if (m_bankData[i].size() > 0) {
+                memcpy(data, m_bankData[i].data(), m_bankData[i].size());
+                data += m_bankData[i].size();
+            }
+        }
+
+        ret = true;
+    }
+
+    return ret;
+}
+
+
+template <class Geometry>
+bool BasicLedBadge<Geometry>::FindBankData
+(
+    const unsigned char* data,
+    size_t               size,
+    size_t               index,
+    size_t&              bankOffset,
+    size_t&              bankSize
+) {
+    bool ret = false;
+
+    if ((data != nullptr) && (size >= m_HeaderSize) && (index < Banks)) {
+        bankOffset = m_HeaderSize;
+        bankSize   = 0;
+
+        for (size_t i = 0; i <= index; ++i) {
+            bankOffset += bankSize;
+            bankSize    = Rows * (data[m_LengthOffset + 2 * i] * 256 + data[m_LengthOffset + 2 * i + 1]);
+        }
+
+        ret = (bankOffset + bankSize <= size);
+    }
+
+    return ret;
+}
+
+
+bool LedBadgeBase::PatchTime
+(
+    unsigned char* data,
+    size_t         size,
+    const std::tm& localTime
+) {
+    bool ret = false;
+
+    if ((data != nullptr) && (size >= m_TimeOffset + 6)) {
+        data[m_TimeOffset]     = localTime.tm_year % 100;
+        data[m_TimeOffset + 1] = localTime.tm_mon + 1;
+        data[m_TimeOffset + 2] = localTime.tm_mday;
+        data[m_TimeOffset + 3] = localTime.tm_hour;
+        data[m_TimeOffset + 4] = localTime.tm_min;
+        data[m_TimeOffset + 5] = std::min(localTime.tm_sec, 59); // no leap seconds
+
+        ret = true;
+    }
+
+    return ret;
+}
+
+
+template <class Geometry>
+void BasicLedBadge<Geometry>::Log
 (
     const char* logString
 ) const {
     if (m_logHandler != nullptr)
         (*m_logHandler)(logString);
 }
+
+
+template class BasicLedBadge<Geometry11x44>;
+template class BasicLedBadge<Geometry12x48>;
+template class BasicLedBadge<Geometry16x64>;
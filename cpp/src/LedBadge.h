@@ -12,6 +12,8 @@
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <cstddef>
+#include <ctime>
 #include <functional>
 #include <vector>
 
@@ -19,16 +21,40 @@
 #define LEDBADGE_INCLUDED
 
 
-class LedBadge {
-public:
-    LedBadge(std::function<void(const char* logString)>* logHandler = nullptr);
-    LedBadge(const LedBadge& original);
-    ~LedBadge(void);
+// the panel and the limits of a badge variant
+// The header layout is the one of the 11x44 badges: a 64 byte header with
+// mode, speed and length fields for up to 8 memory banks.  A bank is encoded
+// in chunks of 8 columns, one byte per row.
+template <size_t RowCount,
+          size_t DisplayWidthValue,
+          size_t BankCountValue  = 8,
+          size_t HeaderSizeValue = 64,
+          size_t MaxSizeValue    = 8192>
+struct LedBadgeGeometry {
+    static constexpr size_t Rows         = RowCount;
+    static constexpr size_t DisplayWidth = DisplayWidthValue;
+    static constexpr size_t Banks        = BankCountValue;
+    static constexpr size_t HeaderSize   = HeaderSizeValue;
+    static constexpr size_t MaxSize      = MaxSizeValue;
+
+    static_assert((Rows > 0) && (DisplayWidth > 0), "LedBadgeGeometry: empty panel");
+    static_assert((Banks > 0) && (Banks <= 8), "LedBadgeGeometry: the header has fields for 1 to 8 memory banks");
+    static_assert(HeaderSize >= 64, "LedBadgeGeometry: the header has at least 64 bytes");
+    static_assert(MaxSize >= HeaderSize + Rows, "LedBadgeGeometry: no space for bank data");
+    static_assert((MaxSize - HeaderSize) / Rows <= 0xffff, "LedBadgeGeometry: the bank length field has 16 bits");
+};
+
 
-    LedBadge&  operator=(const LedBadge& original);
+// Only the 11x44 badge is verified on hardware.  The 12x48 and 16x64 panels
+// are assumed to use the same header layout and are untested.
+typedef LedBadgeGeometry<11, 44> Geometry11x44;
+typedef LedBadgeGeometry<12, 48> Geometry12x48;
+typedef LedBadgeGeometry<16, 64> Geometry16x64;
 
-    void       SetLogHandler(std::function<void(const char* logString)>* logHandler);
 
+// the settings shared by all badge variants
+class LedBadgeBase {
+public:
     enum class Brightness {
         Full,
         High,
@@ -59,6 +85,38 @@ public:
         Eight
     };
 
+    // sets the clock fields in fetched data, e.g. right before it is sent
+    static bool PatchTime(unsigned char* data,
+                          size_t         size,
+                          const std::tm& localTime);
+
+protected:
+    static const size_t m_BrightnessOffset     = 5;
+    static const size_t m_BlinkingOffset       = 6;
+    static const size_t m_AnimatedBorderOffset = 7;
+    static const size_t m_ModeOffset           = 8;  // 1 byte per memory bank
+    static const size_t m_LengthOffset         = 16; // 2 bytes per memory bank
+    static const size_t m_TimeOffset           = 38;
+};
+
+
+template <class Geometry = Geometry11x44>
+class BasicLedBadge : public LedBadgeBase {
+public:
+    static constexpr size_t Rows         = Geometry::Rows;
+    static constexpr size_t DisplayWidth = Geometry::DisplayWidth;
+    static constexpr size_t Banks        = Geometry::Banks;
+    static constexpr size_t HeaderSize   = Geometry::HeaderSize;
+    static constexpr size_t MaxSize      = Geometry::MaxSize; // of the fetched data
+
+    BasicLedBadge(std::function<void(const char* logString)>* logHandler = nullptr);
+    BasicLedBadge(const BasicLedBadge& original);
+    ~BasicLedBadge(void);
+
+    BasicLedBadge& operator=(const BasicLedBadge& original);
+
+    void           SetLogHandler(std::function<void(const char* logString)>* logHandler);
+
     class MemoryBank {
     public:
         MemoryBank(const MemoryBank& original);
@@ -72,15 +130,18 @@ public:
         void SetSpeed(Speed value);
         bool SetData(size_t                                         length,
                      const std::function<bool(size_t x, size_t y)>& ledOn);
+        // already encoded data, Rows bytes per 8 columns
+        bool SetPackedData(const unsigned char* data,
+                           size_t               size);
 
     private:
-        MemoryBank(LedBadge* parent,
-                   size_t    index);
+        MemoryBank(BasicLedBadge* parent,
+                   size_t         index);
 
-        LedBadge* m_parent;
-        size_t    m_index;
+        BasicLedBadge* m_parent;
+        size_t         m_index;
 
-        friend LedBadge;
+        friend BasicLedBadge;
 
         MemoryBank(void); // not implemented
     };
@@ -95,17 +156,39 @@ public:
     void       SetSecond(unsigned char value);
 
     bool       FetchData(std::vector<unsigned char>& dataCopy) const;
+    // into a caller-owned buffer, size is set even if the buffer is too small,
+    // data may be nullptr to query the size
+    bool       FetchData(unsigned char* data,
+                         size_t         capacity,
+                         size_t&        size) const;
+
+    // the location of a bank's data in fetched data
+    static bool FindBankData(const unsigned char* data,
+                             size_t               size,
+                             size_t               index,
+                             size_t&              bankOffset,
+                             size_t&              bankSize);
 
 private:
     std::function<void(const char* logString)>* m_logHandler;
-    static const size_t                         m_HeaderSize = 64;
-    static const size_t                         m_MaxSize    = 8192;
+    static const size_t                         m_HeaderSize = Geometry::HeaderSize;
+    static const size_t                         m_MaxSize    = Geometry::MaxSize;
     unsigned char                               m_header[m_HeaderSize];
-    std::vector<unsigned char>                  m_bankData[8];
+    std::vector<unsigned char>                  m_bankData[Banks];
 
     void Log(const char* logString) const;
 
     friend MemoryBank;
 };
 
+
+// the encoder is instantiated in LedBadge.cpp for the known geometries only
+extern template class BasicLedBadge<Geometry11x44>;
+extern template class BasicLedBadge<Geometry12x48>;
+extern template class BasicLedBadge<Geometry16x64>;
+
+
+typedef BasicLedBadge<> LedBadge;
+
+
 #endif // LEDBADGE_INCLUDED
@@ -0,0 +1,387 @@
+/*                     L E D B A D G E A P I . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+#include <mutex>
+#include <new>
+
+#include "LedBadge.h"
+#include "usb.h"
+
+#include "LedBadgeApi.h"
+
+
+static_assert(LEDBADGE_ROWS == LedBadge::Rows, "LedBadgeApi.h: geometry mismatch");
+static_assert(LEDBADGE_DISPLAY_WIDTH == LedBadge::DisplayWidth, "LedBadgeApi.h: geometry mismatch");
+static_assert(LEDBADGE_BANKS == LedBadge::Banks, "LedBadgeApi.h: geometry mismatch");
+static_assert(static_cast<int>(LEDBADGE_MODE_LASER) == static_cast<int>(LedBadge::Mode::Laser), "LedBadgeApi.h: mode mismatch");
+static_assert(static_cast<int>(LEDBADGE_BRIGHTNESS_LOW) == static_cast<int>(LedBadge::Brightness::Low), "LedBadgeApi.h: brightness mismatch");
+static_assert(LEDBADGE_MAX_SIZE == LedBadge::MaxSize, "LedBadgeApi.h: geometry mismatch");
+
+
+struct ledbadge {
+    ledbadge(ledbadge_log_handler logHandler,
+             void*                userData) : mutex(), logHandler(), badge(&this->logHandler) {
+        if (logHandler != nullptr)
+            this->logHandler = [logHandler, userData](const char* logString){logHandler(logString, userData);};
+    }
+
+    mutable std::mutex                         mutex;
+    std::function<void(const char* logString)> logHandler;
+    LedBadge                                   badge;
+};
+
+
+// runs a function on the bank under the lock of the badge
+template <class BankFunction>
+static int WithBank
+(
+    ledbadge*    badge,
+    size_t       bank,
+    BankFunction function
+) {
+    int ret = LEDBADGE_ERROR_ARGUMENT;
+
+    if ((badge != nullptr) && (bank < LedBadge::Banks)) {
+        try {
+            std::lock_guard<std::mutex> lock(badge->mutex);
+            LedBadge::MemoryBank        memoryBank = badge->badge.GetMemoryBank(bank);
+
+            ret = function(memoryBank);
+        }
+        catch (...) {
+            ret = LEDBADGE_ERROR_MEMORY;
+        }
+    }
+
+    return ret;
+}
+
+
+extern "C" {
+
+
+int ledbadge_api_version(void) {
+    return LEDBADGE_API_VERSION;
+}
+
+
+ledbadge* ledbadge_create
+(
+    ledbadge_log_handler log_handler,
+    void*                user_data
+) {
+    ledbadge* ret = nullptr;
+
+    try {
+        ret = new ledbadge(log_handler, user_data);
+    }
+    catch (...) {
+        ret = nullptr;
+    }
+
+    return ret;
+}
+
+
+void ledbadge_destroy
+(
+    ledbadge* badge
+) {
+    delete badge;
+}
+
+
+int ledbadge_set_brightness
+(
+    ledbadge*                badge,
+    enum ledbadge_brightness brightness
+) {
+    int ret = LEDBADGE_ERROR_ARGUMENT;
+
+    if ((badge != nullptr) && (brightness >= LEDBADGE_BRIGHTNESS_FULL) && (brightness <= LEDBADGE_BRIGHTNESS_LOW)) {
+        try {
+            std::lock_guard<std::mutex> lock(badge->mutex);
+
+            badge->badge.SetBrightness(static_cast<LedBadge::Brightness>(brightness));
+            ret = LEDBADGE_OK;
+        }
+        catch (...) {
+            ret = LEDBADGE_ERROR_MEMORY;
+        }
+    }
+
+    return ret;
+}
+
+
+int ledbadge_set_time
+(
+    ledbadge* badge,
+    int       year,
+    int       month,
+    int       day,
+    int       hour,
+    int       minute,
+    int       second
+) {
+    int ret = LEDBADGE_ERROR_ARGUMENT;
+
+    if ((badge != nullptr) && (year >= 0) && (month >= 1) && (month <= 12) && (day >= 1) && (day <= 31) &&
+        (hour >= 0) && (hour <= 23) && (minute >= 0) && (minute <= 59) && (second >= 0) && (second <= 59)) {
+        try {
+            std::lock_guard<std::mutex> lock(badge->mutex);
+
+            badge->badge.SetYear(year % 100);
+            badge->badge.SetMonth(month);
+            badge->badge.SetDay(day);
+            badge->badge.SetHour(hour);
+            badge->badge.SetMinute(minute);
+            badge->badge.SetSecond(second);
+            ret = LEDBADGE_OK;
+        }
+        catch (...) {
+            ret = LEDBADGE_ERROR_MEMORY;
+        }
+    }
+
+    return ret;
+}
+
+
+int ledbadge_bank_set_blinking
+(
+    ledbadge* badge,
+    size_t    bank,
+    int       on
+) {
+    return WithBank(badge, bank, [on](LedBadge::MemoryBank& memoryBank) {
+        memoryBank.SetBlinking(on != 0);
+        return LEDBADGE_OK;
+    });
+}
+
+
+int ledbadge_bank_set_animated_border
+(
+    ledbadge* badge,
+    size_t    bank,
+    int       on
+) {
+    return WithBank(badge, bank, [on](LedBadge::MemoryBank& memoryBank) {
+        memoryBank.SetAnimatedBorder(on != 0);
+        return LEDBADGE_OK;
+    });
+}
+
+
+int ledbadge_bank_set_mode
+(
+    ledbadge*          badge,
+    size_t             bank,
+    enum ledbadge_mode mode
+) {
+    int ret = LEDBADGE_ERROR_ARGUMENT;
+
+    if ((mode >= LEDBADGE_MODE_LEFT_SCROLL) && (mode <= LEDBADGE_MODE_LASER)) {
+        ret = WithBank(badge, bank, [mode](LedBadge::MemoryBank& memoryBank) {
+            memoryBank.SetMode(static_cast<LedBadge::Mode>(mode));
+            return LEDBADGE_OK;
+        });
+    }
+
+    return ret;
+}
+
+
+int ledbadge_bank_set_speed
+(
+    ledbadge* badge,
+    size_t    bank,
+    int       speed
+) {
+    int ret = LEDBADGE_ERROR_ARGUMENT;
+
+    if ((speed >= 1) && (speed <= 8)) {
+        ret = WithBank(badge, bank, [speed](LedBadge::MemoryBank& memoryBank) {
+            memoryBank.SetSpeed(static_cast<LedBadge::Speed>(speed - 1));
+            return LEDBADGE_OK;
+        });
+    }
+
+    return ret;
+}
+
+
+int ledbadge_bank_set_bitmap
+(
+    ledbadge*            badge,
+    size_t               bank,
+    const unsigned char* bitmap,
+    size_t               width,
+    size_t               stride
+) {
+    int    ret           = LEDBADGE_ERROR_ARGUMENT;
+    size_t lengthInBytes = (width + 7) / 8;
+
+    if (((bitmap != nullptr) || (width == 0)) && (stride >= lengthInBytes)) {
+        ret = WithBank(badge, bank, [bitmap, width, stride, lengthInBytes](LedBadge::MemoryBank& memoryBank) {
+            // the encoding transposes the bytes of the rows into byte columns
+            thread_local std::vector<unsigned char> packed;
+            unsigned char                           lastByteMask = (width % 8 == 0) ? '\xff' : static_cast<unsigned char>(0xffu << (8 - width % 8));
+
+            packed.resize(LedBadge::Rows * lengthInBytes);
+
+            for (size_t byteColumn = 0; byteColumn < lengthInBytes; ++byteColumn) {
+                unsigned char mask = (byteColumn + 1 == lengthInBytes) ? lastByteMask : '\xff';
+
+                for (size_t row = 0; row < LedBadge::Rows; ++row)
+                    packed[LedBadge::Rows * byteColumn + row] = bitmap[stride * row + byteColumn] & mask;
+            }
+
+            return memoryBank.SetPackedData(packed.data(), packed.size()) ? LEDBADGE_OK : LEDBADGE_ERROR_DATA_SIZE;
+        });
+    }
+
+    return ret;
+}
+
+
+int ledbadge_bank_set_packed
+(
+    ledbadge*            badge,
+    size_t               bank,
+    const unsigned char* data,
+    size_t               size
+) {
+    int ret = LEDBADGE_ERROR_ARGUMENT;
+
+    if (((data != nullptr) || (size == 0)) && ((size % LedBadge::Rows) == 0)) {
+        ret = WithBank(badge, bank, [data, size](LedBadge::MemoryBank& memoryBank) {
+            return memoryBank.SetPackedData(data, size) ? LEDBADGE_OK : LEDBADGE_ERROR_DATA_SIZE;
+        });
+    }
+
+    return ret;
+}
+
+
+int ledbadge_fetch
+(
+    const ledbadge* badge,
+    unsigned char*  buffer,
+    size_t          capacity,
+    size_t*         size
+) {
+    int ret = LEDBADGE_ERROR_ARGUMENT;
+
+    if ((badge != nullptr) && (size != nullptr)) {
+        try {
+            std::lock_guard<std::mutex> lock(badge->mutex);
+
+            // with a null buffer a size query, which is not logged
+            if (badge->badge.FetchData(buffer, capacity, *size))
+                ret = LEDBADGE_OK;
+            else if (*size > LEDBADGE_MAX_SIZE)
+                ret = LEDBADGE_ERROR_DATA_SIZE;
+            else
+                ret = LEDBADGE_ERROR_BUFFER_TOO_SMALL;
+        }
+        catch (...) {
+            ret = LEDBADGE_ERROR_MEMORY;
+        }
+    }
+
+    return ret;
+}
+
+
+int ledbadge_send
+(
+    const unsigned char*          data,
+    size_t                        size,
+    const ledbadge_send_options*  options,
+    ledbadge_log_handler          log_handler,
+    void*                         user_data,
+    ledbadge_transfer_statistics* statistics
+) {
+    int                   ret         = LEDBADGE_ERROR_ARGUMENT;
+    ledbadge_send_options sendOptions = {};
+
+    // the fields the caller knows, the others keep their defaults
+    if (options != nullptr)
+        memcpy(&sendOptions, options, std::min(options->struct_size, sizeof(sendOptions)));
+
+    if ((data != nullptr) && (size > 0) &&
+        ((options == nullptr) || (options->struct_size >= sizeof(options->struct_size))) &&
+        ((statistics == nullptr) || (statistics->struct_size >= sizeof(statistics->struct_size))) &&
+        (sendOptions.backend >= LEDBADGE_BACKEND_DEFAULT) && (sendOptions.backend <= LEDBADGE_BACKEND_SIMULATED)) {
+        try {
+            std::function<void(const char* logString)> logHandler;
+            UsbTransferOptions                         transferOptions;
+            UsbTransferStatistics                      transferStatistics;
+
+            if (log_handler != nullptr)
+                logHandler = [log_handler, user_data](const char* logString){log_handler(logString, user_data);};
+
+            switch (sendOptions.backend) {
+                case LEDBADGE_BACKEND_DEFAULT:
+                    break;
+
+                case LEDBADGE_BACKEND_HIDAPI:
+                    transferOptions.backend = UsbBackend::HidApi;
+                    break;
+
+                case LEDBADGE_BACKEND_HIDRAW:
+                    transferOptions.backend = UsbBackend::Hidraw;
+                    break;
+
+                case LEDBADGE_BACKEND_SIMULATED:
+                    transferOptions.backend = UsbBackend::Simulated;
+            }
+
+            transferOptions.devicePath       = sendOptions.device_path;
+            transferOptions.synchronizeClock = (sendOptions.synchronize_clock != 0);
+
+            ret = SendToUsb(data, size, (log_handler != nullptr) ? &logHandler : nullptr, &transferStatistics, transferOptions) ? LEDBADGE_OK : LEDBADGE_ERROR_USB;
+
+            if (statistics != nullptr) {
+                ledbadge_transfer_statistics allStatistics;
+
+                allStatistics.struct_size      = statistics->struct_size;
+                allStatistics.bytes_written    = transferStatistics.bytesWritten;
+                allStatistics.reports_written  = transferStatistics.reportsWritten;
+                allStatistics.retries          = transferStatistics.retries;
+                allStatistics.restarts         = transferStatistics.restarts;
+                allStatistics.open_seconds     = transferStatistics.openSeconds;
+                allStatistics.seconds          = transferStatistics.seconds;
+                allStatistics.write_seconds    = transferStatistics.writeSeconds;
+                allStatistics.bytes_per_second = transferStatistics.bytesPerSecond;
+                allStatistics.clock_error      = transferStatistics.clockError;
+
+                // the fields the caller knows
+                memcpy(statistics, &allStatistics, std::min(statistics->struct_size, sizeof(allStatistics)));
+            }
+        }
+        catch (...) {
+            ret = LEDBADGE_ERROR_MEMORY;
+        }
+    }
+
+    return ret;
+}
+
+
+} // extern "C"
@@ -0,0 +1,178 @@
+/*                       L E D B A D G E A P I . H
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+/* C interface of libledbadge
+ *
+ * All buffers are owned by the caller.  The functions may be called from
+ * any thread, calls on the same ledbadge object are serialized.
+ *
+ * The structures begin with struct_size, which the caller sets to the
+ * sizeof() of the structure it was compiled with.  Fields added in later
+ * versions are appended, the library reads and writes only the fields
+ * within struct_size.
+ */
+
+#ifndef LEDBADGEAPI_INCLUDED
+#define LEDBADGEAPI_INCLUDED
+
+#include <stddef.h>
+
+#if defined(LEDBADGE_BUILDING_API)
+#   define LEDBADGE_API __attribute__((visibility("default")))
+#else
+#   define LEDBADGE_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+
+#define LEDBADGE_API_VERSION 1
+
+#define LEDBADGE_ROWS          11
+#define LEDBADGE_DISPLAY_WIDTH 44
+#define LEDBADGE_BANKS         8
+#define LEDBADGE_MAX_SIZE      8192
+
+
+enum ledbadge_result {
+    LEDBADGE_OK                     =  0,
+    LEDBADGE_ERROR_ARGUMENT         = -1,
+    LEDBADGE_ERROR_DATA_SIZE        = -2, /* the content does not fit into the badge */
+    LEDBADGE_ERROR_BUFFER_TOO_SMALL = -3,
+    LEDBADGE_ERROR_USB              = -4,
+    LEDBADGE_ERROR_MEMORY           = -5
+};
+
+enum ledbadge_brightness {
+    LEDBADGE_BRIGHTNESS_FULL,
+    LEDBADGE_BRIGHTNESS_HIGH,
+    LEDBADGE_BRIGHTNESS_MEDIUM,
+    LEDBADGE_BRIGHTNESS_LOW
+};
+
+enum ledbadge_mode {
+    LEDBADGE_MODE_LEFT_SCROLL,
+    LEDBADGE_MODE_RIGHT_SCROLL,
+    LEDBADGE_MODE_UP_SCROLL,
+    LEDBADGE_MODE_DOWN_SCROLL,
+    LEDBADGE_MODE_CENTERED,
+    LEDBADGE_MODE_SNOWFLAKE,
+    LEDBADGE_MODE_DROP_DOWN,
+    LEDBADGE_MODE_CURTAIN,
+    LEDBADGE_MODE_LASER
+};
+
+/* speed 1 to 8 */
+
+enum ledbadge_backend {
+    LEDBADGE_BACKEND_DEFAULT,  /* set at build time or by LEDBADGE_USB_BACKEND */
+    LEDBADGE_BACKEND_HIDAPI,
+    LEDBADGE_BACKEND_HIDRAW,   /* Linux only */
+    LEDBADGE_BACKEND_SIMULATED /* no device */
+};
+
+
+typedef struct ledbadge ledbadge;
+
+typedef void (*ledbadge_log_handler)(const char* log_string, void* user_data);
+
+/* zero initialized options are the defaults, e.g.
+ * ledbadge_send_options options = {sizeof(ledbadge_send_options)}; */
+typedef struct ledbadge_send_options {
+    size_t                struct_size;
+    enum ledbadge_backend backend;
+    const char*           device_path;       /* NULL for the first badge found */
+    int                   synchronize_clock; /* sets the clock right before the header is written */
+} ledbadge_send_options;
+
+typedef struct ledbadge_transfer_statistics {
+    size_t struct_size;
+    size_t bytes_written;    /* of the data, in the last pass over it */
+    size_t reports_written;  /* including the ones sent again after a restart */
+    size_t retries;
+    size_t restarts;
+    double open_seconds;     /* of the first open */
+    double seconds;          /* of the whole transfer */
+    double write_seconds;    /* of the last pass, without the open */
+    double bytes_per_second; /* bytes_written over write_seconds */
+    double clock_error;      /* with synchronize_clock, in s the badge clock is ahead */
+} ledbadge_transfer_statistics;
+
+
+LEDBADGE_API int       ledbadge_api_version(void);
+
+/* log_handler may be NULL, returns NULL if out of memory */
+LEDBADGE_API ledbadge* ledbadge_create(ledbadge_log_handler log_handler,
+                                       void*                user_data);
+LEDBADGE_API void      ledbadge_destroy(ledbadge* badge);
+
+LEDBADGE_API int       ledbadge_set_brightness(ledbadge*                badge,
+                                               enum ledbadge_brightness brightness);
+LEDBADGE_API int       ledbadge_set_time(ledbadge* badge,
+                                         int       year,
+                                         int       month,
+                                         int       day,
+                                         int       hour,
+                                         int       minute,
+                                         int       second);
+
+LEDBADGE_API int       ledbadge_bank_set_blinking(ledbadge* badge,
+                                                  size_t    bank,
+                                                  int       on);
+LEDBADGE_API int       ledbadge_bank_set_animated_border(ledbadge* badge,
+                                                         size_t    bank,
+                                                         int       on);
+LEDBADGE_API int       ledbadge_bank_set_mode(ledbadge*          badge,
+                                              size_t             bank,
+                                              enum ledbadge_mode mode);
+LEDBADGE_API int       ledbadge_bank_set_speed(ledbadge* badge,
+                                               size_t    bank,
+                                               int       speed);
+
+/* bitmap: LEDBADGE_ROWS rows of stride bytes, 1 bit per LED, the leftmost
+ * LED in the most significant bit, width in LEDs */
+LEDBADGE_API int       ledbadge_bank_set_bitmap(ledbadge*            badge,
+                                                size_t               bank,
+                                                const unsigned char* bitmap,
+                                                size_t               width,
+                                                size_t               stride);
+/* data: already encoded, LEDBADGE_ROWS bytes per 8 columns */
+LEDBADGE_API int       ledbadge_bank_set_packed(ledbadge*            badge,
+                                                size_t               bank,
+                                                const unsigned char* data,
+                                                size_t               size);
+
+/* size is set to the size of the payload, even if the buffer is too small,
+ * buffer may be NULL to query the size */
+LEDBADGE_API int       ledbadge_fetch(const ledbadge* badge,
+                                      unsigned char*  buffer,
+                                      size_t          capacity,
+                                      size_t*         size);
+
+/* options may be NULL for the defaults, statistics may be NULL */
+LEDBADGE_API int       ledbadge_send(const unsigned char*          data,
+                                     size_t                        size,
+                                     const ledbadge_send_options*  options,
+                                     ledbadge_log_handler          log_handler,
+                                     void*                         user_data,
+                                     ledbadge_transfer_statistics* statistics);
+
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LEDBADGEAPI_INCLUDED */
@@ -0,0 +1,243 @@
+/*                     L E D P R E V I E W . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include <QPainter>
+#include <QPaintEvent>
+
+#include "LedPreview.h"
+
+
+static const QColor LedOffColor(60, 20, 20);
+static const QColor LedOnColor(255, 40, 20);
+
+
+LedPreview::LedPreview
+(
+    QWidget* parent
+) : QWidget(parent), m_columns(), m_cache(), m_mode(LedBadge::Mode::LeftScroll), m_speed(LedBadge::Speed::Five),
+    m_animated(false), m_step(0), m_timer() {
+    setMinimumHeight(m_Rows * m_Pitch);
+    setMaximumHeight(m_Rows * m_Pitch);
+    setSizePolicy(QSizePolicy::Expanding, QSizePolicy::Fixed);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+
+    m_cache = QImage(m_DisplayWidth * m_Pitch, m_Rows * m_Pitch, QImage::Format_RGB32);
+    RedrawColumns(0, m_DisplayWidth);
+
+    SetSpeed(m_speed);
+    connect(&m_timer, &QTimer::timeout, this, &LedPreview::Step);
+}
+
+
+void LedPreview::SetData
+(
+    size_t                                         length,
+    const std::function<bool(size_t x, size_t y)>& ledOn
+) {
+    // get real length, as LedBadge::MemoryBank::SetData() does
+    for (; length > 0; --length) {
+        bool rowEmpty = true;
+
+        for (size_t i = 0; i < m_Rows; ++i) {
+            if (ledOn(length - 1, i)) {
+                rowEmpty = false;
+                break;
+            }
+        }
+
+        if (!rowEmpty)
+            break;
+    }
+
+    size_t                      paddedLength = (length + 7) / 8 * 8;
+    std::vector<unsigned short> columns(paddedLength, 0);
+
+    for (size_t x = 0; x < length; ++x) {
+        for (size_t y = 0; y < m_Rows; ++y) {
+            if (ledOn(x, y))
+                columns[x] |= 1 << y;
+        }
+    }
+
+    // find the dirty columns
+    size_t first = 0;
+
+    while ((first < columns.size()) && (first < m_columns.size()) && (columns[first] == m_columns[first]))
+        ++first;
+
+    size_t last = std::max(columns.size(), m_columns.size());
+
+    while ((last > first) && (last <= columns.size()) && (last <= m_columns.size()) && (columns[last - 1] == m_columns[last - 1]))
+        --last;
+
+    m_columns.swap(columns);
+
+    if (first < last) {
+        int cacheWidth = static_cast<int>(std::max(m_columns.size(), m_DisplayWidth)) * m_Pitch;
+
+        size_t dirtyEnd = last;
+
+        if (cacheWidth != m_cache.width()) {
+            int    oldWidth = m_cache.width();
+            QImage   cache(cacheWidth, m_cache.height(), QImage::Format_RGB32);
+            QPainter painter(&cache);
+
+            painter.drawImage(0, 0, m_cache);
+            painter.end();
+
+            m_cache.swap(cache);
+
+            if (cacheWidth > oldWidth)
+                last = std::max(last, static_cast<size_t>(cacheWidth / m_Pitch));
+
+            dirtyEnd = std::max(dirtyEnd, static_cast<size_t>(std::max(oldWidth, cacheWidth) / m_Pitch));
+
+            updateGeometry();
+        }
+
+        last = std::min(last, static_cast<size_t>(m_cache.width() / m_Pitch));
+
+        RedrawColumns(first, last);
+
+        if (!m_animated)
+            update(first * m_Pitch, 0, (dirtyEnd - first) * m_Pitch, height());
+    }
+}
+
+
+void LedPreview::SetMode
+(
+    LedBadge::Mode value
+) {
+    m_mode = value;
+    m_step = 0;
+
+    if (m_animated)
+        update();
+}
+
+
+void LedPreview::SetSpeed
+(
+    LedBadge::Speed value
+) {
+    // roughly the step rate of the badge, from Speed::One (slow) to Speed::Eight (fast)
+    m_speed = value;
+    m_timer.setInterval(15 + 15 * (static_cast<int>(LedBadge::Speed::Eight) - static_cast<int>(value)));
+}
+
+
+void LedPreview::SetAnimated
+(
+    bool on
+) {
+    m_animated = on;
+    m_step     = 0;
+
+    if (on)
+        m_timer.start();
+    else
+        m_timer.stop();
+
+    update();
+}
+
+
+QSize LedPreview::sizeHint(void) const {
+    return m_cache.size();
+}
+
+
+void LedPreview::paintEvent
+(
+    QPaintEvent* event
+) {
+    QPainter painter(this);
+
+    if (m_animated) {
+        int    viewportWidth = m_DisplayWidth * m_Pitch;
+        size_t length        = m_columns.size();
+        int    x             = 0;
+        int    y             = 0;
+
+        switch (m_mode) {
+            case LedBadge::Mode::LeftScroll:
+                x = (static_cast<int>(m_DisplayWidth) - static_cast<int>(m_step % (length + m_DisplayWidth))) * m_Pitch;
+                break;
+
+            case LedBadge::Mode::RightScroll:
+                x = (static_cast<int>(m_step % (length + m_DisplayWidth)) - static_cast<int>(length)) * m_Pitch;
+                break;
+
+            case LedBadge::Mode::UpScroll:
+                y = (static_cast<int>(m_Rows) - static_cast<int>(m_step % (2 * m_Rows))) * m_Pitch;
+                break;
+
+            case LedBadge::Mode::DownScroll:
+                y = (static_cast<int>(m_step % (2 * m_Rows)) - static_cast<int>(m_Rows)) * m_Pitch;
+                break;
+
+            case LedBadge::Mode::Centered:
+                if (length < m_DisplayWidth)
+                    x = static_cast<int>((m_DisplayWidth - length) / 2) * m_Pitch;
+                break;
+
+            default:
+                // the remaining effects are shown as a still image
+                break;
+        }
+
+        painter.fillRect(rect(), Qt::black);
+        painter.setClipRect(0, 0, viewportWidth, height());
+        painter.drawImage(x, y, m_cache, 0, 0, std::min(static_cast<int>(length) * m_Pitch, m_cache.width()), m_cache.height());
+    }
+    else {
+        QRect dirty = event->rect();
+
+        painter.drawImage(dirty.topLeft(), m_cache, dirty);
+
+        if (dirty.right() >= m_cache.width())
+            painter.fillRect(m_cache.width(), 0, dirty.right() - m_cache.width() + 1, height(), Qt::black);
+    }
+}
+
+
+void LedPreview::RedrawColumns
+(
+    size_t first,
+    size_t last
+) {
+    QPainter painter(&m_cache);
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.fillRect(first * m_Pitch, 0, (last - first) * m_Pitch, m_cache.height(), Qt::black);
+    painter.setPen(Qt::NoPen);
+
+    for (size_t x = first; x < last; ++x) {
+        unsigned short column = (x < m_columns.size()) ? m_columns[x] : 0;
+
+        for (size_t y = 0; y < m_Rows; ++y) {
+            painter.setBrush(((column >> y) & 1) ? LedOnColor : LedOffColor);
+            painter.drawEllipse(x * m_Pitch, y * m_Pitch, m_DotSize, m_DotSize);
+        }
+    }
+}
+
+
+void LedPreview::Step(void) {
+    ++m_step;
+    update();
+}
@@ -0,0 +1,66 @@
+/*                       L E D P R E V I E W . H
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef LEDPREVIEW_INCLUDED
+#define LEDPREVIEW_INCLUDED
+
+#include <functional>
+#include <vector>
+
+#include <QImage>
+#include <QTimer>
+#include <QWidget>
+
+#include "LedBadge.h"
+
+
+// shows a memory bank as the badge displays it: one dot per LED, padded to
+// whole bytes like the encoded bank data
+class LedPreview : public QWidget {
+    Q_OBJECT
+public:
+    LedPreview(QWidget* parent = 0);
+
+    void  SetData(size_t                                         length,
+                  const std::function<bool(size_t x, size_t y)>& ledOn);
+    void  SetMode(LedBadge::Mode value);
+    void  SetSpeed(LedBadge::Speed value);
+    void  SetAnimated(bool on);
+
+    QSize sizeHint(void) const override;
+
+protected:
+    void  paintEvent(QPaintEvent* event) override;
+
+private:
+    static constexpr size_t     m_Rows         = LedBadge::Rows;
+    static constexpr size_t     m_DisplayWidth = LedBadge::DisplayWidth;
+    static constexpr int        m_Pitch        = 4;
+    static constexpr int        m_DotSize      = 3;
+
+    std::vector<unsigned short> m_columns; // one bit per row
+    QImage                      m_cache;
+    LedBadge::Mode              m_mode;
+    LedBadge::Speed             m_speed;
+    bool                        m_animated;
+    size_t                      m_step;
+    QTimer                      m_timer;
+
+    void RedrawColumns(size_t first,
+                       size_t last);
+    void Step(void);
+};
+
+
+#endif // LEDPREVIEW_INCLUDED
@@ -12,40 +12,60 @@
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <algorithm>
+#include <sstream>
+
 #include <QDate>
+#include <QFile>
+#include <QFileDialog>
 #include <QFontDialog>
 #include <QGridLayout>
-#include <QLineEdit>
+#include <QIcon>
+#include <QInputDialog>
+#include <QLabel>
+#include <QMetaObject>
+#include <QPixmap>
 #include <QPushButton>
+#include <QStandardPaths>
+#include <QVBoxLayout>
 
 #include "LedBadge.h"
+#include "TextRenderer.h"
 #include "usb.h"
 #include "MainWindow.h"
 
 
+static const double Threshold       = 0.7;
+static const int    ThumbnailWidth  = 132;
+static const int    ThumbnailHeight = 33;
+static const size_t ThumbnailCount  = 64;
+
+
 MainWindow::MainWindow
 (
     QWidget* parent
-) : QMainWindow(parent) {
+) : QMainWindow(parent), m_logHandler(), m_usbWatcher(&m_logHandler), m_ledBadge(&m_logHandler), m_encodedBank(),
+    m_messageLibrary(&m_logHandler) {
     setWindowTitle(tr("LED Badge Designer"));
 
+    // the USB watcher logs from its own thread
+    m_logHandler = [this](const char* logString) {
+        QString text = QString::fromUtf8(logString);
+
+        QMetaObject::invokeMethod(m_logWidget, [this, text](){(*m_logWidget)(text.toUtf8().constData());});
+    };
+
     QWidget*     centralWidget = new QWidget(this);
     QGridLayout* mainLayout    = new QGridLayout(centralWidget);
 
-    QFont        renderedInputFont;
-    renderedInputFont.setStyleStrategy(QFont::NoAntialias);
-
     for (size_t i = 0; i < 8; ++i) {
         QLabel*      title      = new QLabel(tr("Bank %1:").arg(i + 1));
         QPushButton* fontButton = new QPushButton(tr("Font"));
-        QLineEdit*   input      = new QLineEdit();
 
-        m_renderedInput[i] = new QLabel();
+        m_input[i]   = new QLineEdit();
+        m_preview[i] = new LedPreview();
 
-        m_renderedInput[i]->setMinimumHeight(11);
-        m_renderedInput[i]->setMaximumHeight(11);
-        m_renderedInput[i]->setStyleSheet("background-color: white; color: black;");
-        m_renderedInput[i]->setFont(renderedInputFont);
+        m_font[i].setStyleStrategy(QFont::NoAntialias);
 
         m_blinkingSet[i]       = new QCheckBox(tr("blinking"));
         m_animatedBorderSet[i] = new QCheckBox(tr("animated border"));
@@ -81,8 +101,8 @@ MainWindow::MainWindow
         mainLayout->addWidget(title, i * 4, 0);
 
         mainLayout->addWidget(fontButton, i * 4 + 1, 0);
-        mainLayout->addWidget(input, i * 4 + 1, 1);
-        mainLayout->addWidget(m_renderedInput[i], i * 4 + 1, 2, 1, 4);
+        mainLayout->addWidget(m_input[i], i * 4 + 1, 1);
+        mainLayout->addWidget(m_preview[i], i * 4 + 1, 2, 1, 4);
 
         mainLayout->addWidget(m_blinkingSet[i], i * 4 + 2, 0);
         mainLayout->addWidget(m_animatedBorderSet[i], i * 4 + 2, 1);
@@ -94,13 +114,24 @@ MainWindow::MainWindow
         mainLayout->addItem(new QSpacerItem(10, 10), i * 4 + 3, 0);
 
         connect(fontButton, &QPushButton::clicked, this, [this, i](){MainWindow::SelectFont(i);});
-        connect(input, &QLineEdit::textChanged, m_renderedInput[i], &QLabel::setText);
+        connect(m_input[i], &QLineEdit::textChanged, this, [this, i](){MainWindow::UpdatePreview(i);});
+        connect(m_modeSelection[i], &QComboBox::currentIndexChanged, this, [this, i](){
+            m_preview[i]->SetMode(static_cast<LedBadge::Mode>(m_modeSelection[i]->currentData().toInt()));
+        });
+        connect(m_speedSelection[i], &QComboBox::currentIndexChanged, this, [this, i](){
+            m_preview[i]->SetSpeed(static_cast<LedBadge::Speed>(m_speedSelection[i]->currentData().toInt()));
+        });
+
+        m_preview[i]->SetSpeed(static_cast<LedBadge::Speed>(m_speedSelection[i]->currentData().toInt()));
     }
 
     QLabel*      brightnessLabel = new QLabel(tr("Brightness:"));
+    QPushButton* exportButton    = new QPushButton(tr("Export"));
     QPushButton* sendButton      = new QPushButton(tr("Send"));
 
     m_brightnessSelection = new QComboBox();
+    m_animatePreview      = new QCheckBox(tr("animate preview"));
+    m_sendOnAttach        = new QCheckBox(tr("send on attach"));
 
     m_brightnessSelection->addItem(tr("full"), static_cast<int>(LedBadge::Brightness::Full));
     m_brightnessSelection->addItem(tr("hight"), static_cast<int>(LedBadge::Brightness::High));
@@ -109,15 +140,49 @@ MainWindow::MainWindow
 
     mainLayout->addWidget(brightnessLabel, 32, 0);
     mainLayout->addWidget(m_brightnessSelection, 32, 1);
+    mainLayout->addWidget(m_animatePreview, 32, 2);
+    mainLayout->addWidget(exportButton, 32, 3);
+    mainLayout->addWidget(m_sendOnAttach, 32, 4);
     mainLayout->addWidget(sendButton, 32, 5);
 
+    connect(exportButton, &QPushButton::clicked, this, &MainWindow::Export);
     connect(sendButton, &QPushButton::clicked, this, &MainWindow::Send);
+    connect(m_sendOnAttach, &QCheckBox::toggled, this, &MainWindow::SendOnAttach);
+    connect(m_animatePreview, &QCheckBox::toggled, this, [this](bool on){
+        for (size_t i = 0; i < 8; ++i)
+            m_preview[i]->SetAnimated(on);
+    });
 
     m_logWidget = new LogWidget();
 
     mainLayout->addItem(new QSpacerItem(10, 10), 33, 0);
     mainLayout->addWidget(m_logWidget, 34, 0, 1, 6);
 
+    // the message library beside the banks
+    QVBoxLayout* libraryLayout = new QVBoxLayout();
+    QPushButton* saveButton    = new QPushButton(tr("Save to Library"));
+
+    m_messageSearch = new QLineEdit();
+    m_messageList   = new QListWidget();
+
+    m_messageSearch->setPlaceholderText(tr("Search"));
+    m_messageList->setIconSize(QSize(ThumbnailWidth, ThumbnailHeight));
+
+    libraryLayout->addWidget(new QLabel(tr("Library:")));
+    libraryLayout->addWidget(m_messageSearch);
+    libraryLayout->addWidget(m_messageList);
+    libraryLayout->addWidget(saveButton);
+    mainLayout->addLayout(libraryLayout, 0, 6, 35, 1);
+
+    connect(saveButton, &QPushButton::clicked, this, &MainWindow::SaveMessage);
+    connect(m_messageSearch, &QLineEdit::textChanged, this, &MainWindow::SearchMessages);
+    connect(m_messageList, &QListWidget::itemActivated, this, [this](QListWidgetItem* item){
+        MainWindow::LoadMessage(item->data(Qt::UserRole).toULongLong());
+    });
+
+    if (m_messageLibrary.Open(QStandardPaths::writableLocation(QStandardPaths::AppDataLocation)))
+        SearchMessages(QString());
+
     setCentralWidget(centralWidget);
 }
 
@@ -129,28 +194,97 @@ void MainWindow::SelectFont
     assert(i < 8);
 
     bool  ok                = true;
-    QFont renderedInputFont = QFontDialog::getFont(&ok, m_renderedInput[i]->font(), this);
+    QFont renderedInputFont = QFontDialog::getFont(&ok, m_font[i], this);
 
     renderedInputFont.setStyleStrategy(QFont::NoAntialias);
 
-    if (ok)
-        m_renderedInput[i]->setFont(renderedInputFont);
+    if (ok) {
+        m_font[i] = renderedInputFont;
+        UpdatePreview(i);
+    }
+}
+
+
+void MainWindow::UpdatePreview
+(
+    size_t i
+) {
+    assert(i < 8);
+
+    QImage image = RenderText(m_input[i]->text(), m_font[i], LedBadge::Rows);
+
+    m_preview[i]->SetData(image.width(), [&image](size_t x, size_t y) {return LedOn(image, x, y, Threshold);});
 }
 
 
 void MainWindow::Send(void) {
-    std::function<void(const char* logString)> logHandler = [this](const char* logString){(*m_logWidget)(logString);};
-    LedBadge ledBadge(&logHandler);
-    bool     ok = true;
+    std::vector<unsigned char> data;
 
-    ledBadge.SetBrightness(static_cast<LedBadge::Brightness>(m_brightnessSelection->currentData().toInt()));
+    if (BuildPayload(data)) {
+        UsbTransferOptions options;
 
-    for (size_t i = 0; i < 8; ++i) {
-        QPixmap pixmap = m_renderedInput[i]->grab();
-        QImage  image  = pixmap.toImage();
+        options.synchronizeClock = true;
+
+        SendToUsb(data, &m_logHandler, nullptr, options);
+
+        // the last sent payload goes to the next attached badges too
+        if (m_usbWatcher.IsRunning())
+            m_usbWatcher.Arm(data);
+    }
+}
+
+
+void MainWindow::SendOnAttach
+(
+    bool on
+) {
+    if (on) {
+        std::vector<unsigned char> data;
+
+        if (BuildPayload(data)) {
+            m_usbWatcher.Arm(data);
+            m_usbWatcher.Start();
+        }
+        else
+            m_sendOnAttach->setChecked(false);
+    }
+    else {
+        m_usbWatcher.Stop();
+        m_usbWatcher.Disarm();
+    }
+}
+
+
+// writes the payload to a file, e.g. for a playlist
+void MainWindow::Export(void) {
+    std::vector<unsigned char> data;
+
+    if (BuildPayload(data)) {
+        QString fileName = QFileDialog::getSaveFileName(this, tr("Export Payload"), QString(), tr("Payload (*.bin)"));
+
+        if (!fileName.isEmpty()) {
+            QFile file(fileName);
+
+            if (!file.open(QIODevice::WriteOnly) || (file.write(reinterpret_cast<const char*>(data.data()), data.size()) != static_cast<qint64>(data.size())))
+                m_logHandler(QString("Error: MainWindow::Export(): Cannot write %1\n").arg(fileName).toUtf8().constData());
+        }
+    }
+}
+
+
+// only the banks whose text, font or threshold changed since the last call are
+// rendered and encoded again, the header settings are set directly
+bool MainWindow::BuildPayload
+(
+    std::vector<unsigned char>& data
+) {
+    LedBadge& ledBadge     = m_ledBadge;
+    bool      ok           = true;
+    size_t    encodedBanks = 0;
 
-        assert(image.height() == 11);
+    ledBadge.SetBrightness(static_cast<LedBadge::Brightness>(m_brightnessSelection->currentData().toInt()));
 
+    for (size_t i = 0; i < 8; ++i) {
         LedBadge::MemoryBank memoryBank = ledBadge.GetMemoryBank(i);
 
         memoryBank.SetBlinking(m_blinkingSet[i]->checkState() == Qt::Checked);
@@ -158,9 +292,29 @@ void MainWindow::Send(void) {
         memoryBank.SetMode(static_cast<LedBadge::Mode>(m_modeSelection[i]->currentData().toInt()));
         memoryBank.SetSpeed(static_cast<LedBadge::Speed>(m_speedSelection[i]->currentData().toInt()));
 
-        ok &= memoryBank.SetData(image.width(), [&image](size_t x, size_t y) {return (image.pixelColor(x, y).valueF() > 0.7) ? false : true;});
+        EncodedBank  inputs      = {true, m_input[i]->text(), m_font[i].toString(), Threshold};
+        EncodedBank& encodedBank = m_encodedBank[i];
+
+        if (!encodedBank.valid || (encodedBank.text != inputs.text) || (encodedBank.font != inputs.font) || (encodedBank.threshold != inputs.threshold)) {
+            QImage image = RenderText(inputs.text, m_font[i], LedBadge::Rows);
+
+            assert(image.height() == LedBadge::Rows);
+
+            if (memoryBank.SetData(image.width(), [&image](size_t x, size_t y) {return LedOn(image, x, y, Threshold);}))
+                encodedBank = inputs;
+            else {
+                encodedBank.valid = false;
+                ok                = false;
+            }
+
+            ++encodedBanks;
+        }
     }
 
+    std::stringstream logstream;
+    logstream << "Info: MainWindow::BuildPayload(): " << encodedBanks << " of 8 banks encoded\n";
+    m_logHandler(logstream.str().c_str());
+
     if (ok) {
         QDate date = QDate::currentDate();
 
@@ -174,9 +328,122 @@ void MainWindow::Send(void) {
         ledBadge.SetMinute(time.minute());
         ledBadge.SetSecond(time.second());
 
-        std::vector<unsigned char> data;
+        ok = ledBadge.FetchData(data);
+    }
+
+    return ok;
+}
+
+
+// stores the design together with its payload, the payload is written with the
+// clock of the save time, Send() updates it
+void MainWindow::SaveMessage(void) {
+    std::vector<unsigned char> data;
+
+    if (BuildPayload(data)) {
+        bool    ok   = false;
+        QString name = QInputDialog::getText(this, tr("Save to Library"), tr("Name:"), QLineEdit::Normal, m_input[0]->text(), &ok);
+
+        if (ok && !name.isEmpty()) {
+            MessageLibrary::Message message;
+
+            message.name       = name;
+            message.brightness = m_brightnessSelection->currentData().toInt();
+
+            for (size_t i = 0; i < 8; ++i) {
+                MessageLibrary::BankDesign& bank = message.banks[i];
+
+                bank.text           = m_input[i]->text();
+                bank.font           = m_font[i].toString();
+                bank.blinking       = (m_blinkingSet[i]->checkState() == Qt::Checked);
+                bank.animatedBorder = (m_animatedBorderSet[i]->checkState() == Qt::Checked);
+                bank.mode           = m_modeSelection[i]->currentData().toInt();
+                bank.speed          = m_speedSelection[i]->currentData().toInt();
+            }
+
+            message.payload   = data;
+            message.thumbnail = m_preview[0]->grab().toImage().scaled(ThumbnailWidth, ThumbnailHeight, Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+            if (m_messageLibrary.Append(message))
+                SearchMessages(m_messageSearch->text());
+        }
+    }
+}
+
+
+// restores a design without rendering, the banks' data is taken from the
+// stored payload and the encode cache is set to its inputs
+void MainWindow::LoadMessage
+(
+    size_t index
+) {
+    MessageLibrary::Message message;
+
+    if (m_messageLibrary.Load(index, message)) {
+        m_brightnessSelection->setCurrentIndex(std::max(m_brightnessSelection->findData(message.brightness), 0));
+
+        for (size_t i = 0; i < 8; ++i) {
+            const MessageLibrary::BankDesign& bank = message.banks[i];
+
+            m_blinkingSet[i]->setChecked(bank.blinking);
+            m_animatedBorderSet[i]->setChecked(bank.animatedBorder);
+            m_modeSelection[i]->setCurrentIndex(std::max(m_modeSelection[i]->findData(bank.mode), 0));
+            m_speedSelection[i]->setCurrentIndex(std::max(m_speedSelection[i]->findData(bank.speed), 0));
+
+            m_font[i].fromString(bank.font);
+            m_font[i].setStyleStrategy(QFont::NoAntialias);
+
+            size_t bankOffset = 0;
+            size_t bankSize   = 0;
+
+            m_input[i]->blockSignals(true);
+            m_input[i]->setText(bank.text);
+            m_input[i]->blockSignals(false);
+
+            if (LedBadge::FindBankData(message.payload.data(), message.payload.size(), i, bankOffset, bankSize) &&
+                m_ledBadge.GetMemoryBank(i).SetPackedData(message.payload.data() + bankOffset, bankSize)) {
+                const unsigned char* bankData = message.payload.data() + bankOffset;
+
+                m_encodedBank[i] = {true, bank.text, m_font[i].toString(), Threshold};
+
+                // the preview shows the stored bank data, Rows bytes per 8 columns
+                m_preview[i]->SetData(bankSize / LedBadge::Rows * 8, [bankData](size_t x, size_t y) {
+                    return ((bankData[LedBadge::Rows * (x / 8) + y] >> (7 - x % 8)) & 1) != 0;
+                });
+            }
+            else {
+                m_encodedBank[i].valid = false;
+                UpdatePreview(i);
+            }
+        }
+    }
+}
+
+
+void MainWindow::SearchMessages
+(
+    const QString& pattern
+) {
+    m_messageList->clear();
+
+    std::vector<size_t> indices = m_messageLibrary.Search(pattern);
+
+    // the names come from the index, the thumbnails of the first hits are read
+    // from the messages once
+    m_messageIcons.resize(m_messageLibrary.Size());
+
+    for (size_t i = 0; i < indices.size(); ++i) {
+        size_t           index = indices[i];
+        QListWidgetItem* item  = new QListWidgetItem(m_messageLibrary.Name(index), m_messageList);
+
+        if ((i < ThumbnailCount) && m_messageIcons[index].isNull()) {
+            MessageLibrary::Message message;
+
+            if (m_messageLibrary.Load(index, message))
+                m_messageIcons[index] = QIcon(QPixmap::fromImage(message.thumbnail));
+        }
 
-        if (ledBadge.FetchData(data))
-            SendToUsb(data, &logHandler);
+        item->setIcon(m_messageIcons[index]);
+        item->setData(Qt::UserRole, static_cast<qulonglong>(index));
     }
 }
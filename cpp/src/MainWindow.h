@@ -15,12 +15,23 @@
 #ifndef MAINWINDOW_INCLUDED
 #define MAINWINDOW_INCLUDED
 
+#include <functional>
+#include <vector>
+
 #include <QCheckBox>
 #include <QComboBox>
-#include <QLabel>
+#include <QFont>
+#include <QIcon>
+#include <QLineEdit>
+#include <QListWidget>
 #include <QMainWindow>
+#include <QString>
 
+#include "LedBadge.h"
+#include "LedPreview.h"
 #include "LogWidget.h"
+#include "MessageLibrary.h"
+#include "UsbWatcher.h"
 
 
 class MainWindow : public QMainWindow {
@@ -30,16 +41,46 @@ public:
 
 public slots:
     void SelectFont(size_t i);
+    void UpdatePreview(size_t i);
     void Send(void);
+    void SendOnAttach(bool on);
+    void Export(void);
+    void SaveMessage(void);
+    void LoadMessage(size_t index);
+    void SearchMessages(const QString& pattern);
 
 private:
-    QComboBox* m_brightnessSelection;
-    QCheckBox* m_blinkingSet[8];
-    QCheckBox* m_animatedBorderSet[8];
-    QComboBox* m_modeSelection[8];
-    QComboBox* m_speedSelection[8];
-    QLabel*    m_renderedInput[8];
-    LogWidget* m_logWidget;
+    QComboBox*   m_brightnessSelection;
+    QCheckBox*   m_animatePreview;
+    QCheckBox*   m_sendOnAttach;
+    QLineEdit*   m_input[8];
+    QFont        m_font[8];
+    QCheckBox*   m_blinkingSet[8];
+    QCheckBox*   m_animatedBorderSet[8];
+    QComboBox*   m_modeSelection[8];
+    QComboBox*   m_speedSelection[8];
+    LedPreview*  m_preview[8];
+    LogWidget*   m_logWidget;
+    QLineEdit*   m_messageSearch;
+    QListWidget* m_messageList;
+
+    std::function<void(const char* logString)> m_logHandler;
+    UsbWatcher                                 m_usbWatcher;
+
+    // the inputs of the bank data encoded in m_ledBadge
+    struct EncodedBank {
+        bool    valid;
+        QString text;
+        QString font;
+        double  threshold;
+    };
+
+    LedBadge                                   m_ledBadge;
+    EncodedBank                                m_encodedBank[8];
+    MessageLibrary                             m_messageLibrary;
+    std::vector<QIcon>                         m_messageIcons;
+
+    bool BuildPayload(std::vector<unsigned char>& data);
 };
 
 
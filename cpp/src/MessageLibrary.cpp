@@ -0,0 +1,442 @@
+/*                 M E S S A G E L I B R A R Y . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include <QBuffer>
+#include <QByteArray>
+#include <QDataStream>
+#include <QDir>
+
+#include "MessageLibrary.h"
+
+
+// messages.dat: records of "LBMR", record size (quint32) and the record
+// messages.idx: "LBMI", version, entry size, reserved (quint32 each) and the entries
+// An entry: the offset of the record behind its magic and size (quint64), the
+// record size (quint32), reserved (quint32) and the name (UTF-8, zero padded,
+// may be truncated).  All numbers are little-endian.
+static const char    RecordMagic[4]  = {'L', 'B', 'M', 'R'};
+static const char    IndexMagic[4]   = {'L', 'B', 'M', 'I'};
+static const quint32 IndexVersion    = 1;
+static const size_t  IndexHeaderSize = 16;
+static const size_t  EntrySize       = 64;
+static const size_t  NameOffset      = 16;
+static const size_t  NameSize        = EntrySize - NameOffset;
+
+
+static void WriteUInt32
+(
+    unsigned char* data,
+    quint32        value
+) {
+    for (size_t i = 0; i < 4; ++i)
+        data[i] = static_cast<unsigned char>(value >> (8 * i));
+}
+
+
+static quint32 ReadUInt32
+(
+    const unsigned char* data
+) {
+    quint32 ret = 0;
+
+    for (size_t i = 0; i < 4; ++i)
+        ret |= static_cast<quint32>(data[i]) << (8 * i);
+
+    return ret;
+}
+
+
+static void WriteEntry
+(
+    unsigned char* entry,
+    quint64        offset,
+    quint32        size,
+    const QString& name
+) {
+    QByteArray utf8     = name.toUtf8();
+    int        nameSize = std::min(utf8.size(), static_cast<int>(NameSize));
+
+    // do not cut a multi-byte character
+    while ((nameSize > 0) && (nameSize < utf8.size()) && ((static_cast<unsigned char>(utf8[nameSize]) & 0xc0) == 0x80))
+        --nameSize;
+
+    std::memset(entry, 0, EntrySize);
+    WriteUInt32(entry, static_cast<quint32>(offset));
+    WriteUInt32(entry + 4, static_cast<quint32>(offset >> 32));
+    WriteUInt32(entry + 8, size);
+    std::memcpy(entry + NameOffset, utf8.constData(), nameSize);
+}
+
+
+static void ReadEntry
+(
+    const unsigned char* entry,
+    quint64&             offset,
+    quint32&             size
+) {
+    offset = ReadUInt32(entry) | (static_cast<quint64>(ReadUInt32(entry + 4)) << 32);
+    size   = ReadUInt32(entry + 8);
+}
+
+
+MessageLibrary::MessageLibrary
+(
+    std::function<void(const char* logString)>* logHandler
+) : m_logHandler(logHandler), m_dataFile(), m_indexFile(), m_index(nullptr), m_indexSize(0) {}
+
+
+MessageLibrary::~MessageLibrary(void) {
+    if (m_index != nullptr)
+        m_indexFile.unmap(const_cast<unsigned char*>(m_index));
+}
+
+
+bool MessageLibrary::Open
+(
+    const QString& directory
+) {
+    bool ret = false;
+
+    if (m_index != nullptr) {
+        m_indexFile.unmap(const_cast<unsigned char*>(m_index));
+        m_index     = nullptr;
+        m_indexSize = 0;
+    }
+
+    m_dataFile.close();
+    m_indexFile.close();
+
+    if (QDir().mkpath(directory)) {
+        QDir dir(directory);
+
+        m_dataFile.setFileName(dir.filePath("messages.dat"));
+        m_indexFile.setFileName(dir.filePath("messages.idx"));
+
+        if (!m_dataFile.open(QIODevice::ReadWrite))
+            Log(("Error: MessageLibrary::Open(): Can not open " + m_dataFile.fileName() + "\n").toUtf8().constData());
+        else if (!m_indexFile.open(QIODevice::ReadWrite))
+            Log(("Error: MessageLibrary::Open(): Can not open " + m_indexFile.fileName() + "\n").toUtf8().constData());
+        else if (Map())
+            ret = true;
+        else
+            ret = Rebuild();
+    }
+    else
+        Log(("Error: MessageLibrary::Open(): Can not create " + directory + "\n").toUtf8().constData());
+
+    return ret;
+}
+
+
+size_t MessageLibrary::Size(void) const {
+    size_t ret = 0;
+
+    if (m_index != nullptr)
+        ret = (m_indexSize - IndexHeaderSize) / EntrySize;
+
+    return ret;
+}
+
+
+QString MessageLibrary::Name
+(
+    size_t index
+) const {
+    QString ret;
+
+    if (index < Size()) {
+        const char* name = reinterpret_cast<const char*>(m_index + IndexHeaderSize + index * EntrySize + NameOffset);
+
+        ret = QString::fromUtf8(name, static_cast<int>(strnlen(name, NameSize)));
+    }
+
+    return ret;
+}
+
+
+std::vector<size_t> MessageLibrary::Search
+(
+    const QString& pattern
+) const {
+    std::vector<size_t> ret;
+    size_t              size = Size();
+
+    ret.reserve(size);
+
+    for (size_t i = size; i > 0; --i) {
+        if (pattern.isEmpty() || Name(i - 1).contains(pattern, Qt::CaseInsensitive))
+            ret.push_back(i - 1);
+    }
+
+    return ret;
+}
+
+
+bool MessageLibrary::Load
+(
+    size_t   index,
+    Message& message
+) const {
+    bool ret = false;
+
+    if (index < Size()) {
+        quint64 offset = 0;
+        quint32 size   = 0;
+
+        ReadEntry(m_index + IndexHeaderSize + index * EntrySize, offset, size);
+
+        if (m_dataFile.seek(static_cast<qint64>(offset))) {
+            QByteArray  record = m_dataFile.read(size);
+            QDataStream stream(record);
+            QByteArray  payload;
+            QByteArray  thumbnail;
+
+            stream.setVersion(QDataStream::Qt_6_0);
+            stream >> message.name >> message.brightness;
+
+            for (size_t i = 0; i < 8; ++i) {
+                BankDesign& bank = message.banks[i];
+
+                stream >> bank.text >> bank.font >> bank.blinking >> bank.animatedBorder >> bank.mode >> bank.speed;
+            }
+
+            stream >> payload >> thumbnail;
+
+            if ((record.size() == static_cast<int>(size)) && (stream.status() == QDataStream::Ok)) {
+                message.payload.assign(payload.constBegin(), payload.constEnd());
+                message.thumbnail.loadFromData(thumbnail, "PNG");
+                ret = true;
+            }
+        }
+
+        if (!ret)
+            Log("Error: MessageLibrary::Load(): Damaged message record\n");
+    }
+    else
+        Log("Error: MessageLibrary::Load(): Index out of range\n");
+
+    return ret;
+}
+
+
+bool MessageLibrary::Append
+(
+    const Message& message
+) {
+    bool ret = false;
+
+    if (m_dataFile.isOpen()) {
+        QByteArray  record;
+        QByteArray  thumbnail;
+        QBuffer     thumbnailBuffer(&thumbnail);
+        QDataStream stream(&record, QIODevice::WriteOnly);
+
+        thumbnailBuffer.open(QIODevice::WriteOnly);
+        message.thumbnail.save(&thumbnailBuffer, "PNG");
+
+        stream.setVersion(QDataStream::Qt_6_0);
+        stream << message.name << message.brightness;
+
+        for (size_t i = 0; i < 8; ++i) {
+            const BankDesign& bank = message.banks[i];
+
+            stream << bank.text << bank.font << bank.blinking << bank.animatedBorder << bank.mode << bank.speed;
+        }
+
+        stream << QByteArray(reinterpret_cast<const char*>(message.payload.data()), static_cast<int>(message.payload.size()))
+               << thumbnail;
+
+        unsigned char header[8];
+        qint64        offset = m_dataFile.size();
+
+        std::memcpy(header, RecordMagic, 4);
+        WriteUInt32(header + 4, static_cast<quint32>(record.size()));
+
+        if (m_dataFile.seek(offset) &&
+            (m_dataFile.write(reinterpret_cast<const char*>(header), sizeof(header)) == sizeof(header)) &&
+            (m_dataFile.write(record) == record.size()) &&
+            m_dataFile.flush())
+            ret = AppendIndexEntry(static_cast<quint64>(offset) + sizeof(header), static_cast<quint32>(record.size()), message.name);
+        else {
+            m_dataFile.resize(offset); // drop a partial record
+            Log("Error: MessageLibrary::Append(): Can not write the message\n");
+        }
+    }
+    else
+        Log("Error: MessageLibrary::Append(): The library is not open\n");
+
+    return ret;
+}
+
+
+// maps the index when its entries cover the data file exactly
+bool MessageLibrary::Map(void) {
+    bool   ret  = false;
+    qint64 size = m_indexFile.size();
+
+    if (m_index != nullptr) {
+        m_indexFile.unmap(const_cast<unsigned char*>(m_index));
+        m_index     = nullptr;
+        m_indexSize = 0;
+    }
+
+    if ((size >= static_cast<qint64>(IndexHeaderSize)) && (((size - IndexHeaderSize) % EntrySize) == 0))
+        m_index = m_indexFile.map(0, size);
+
+    if (m_index != nullptr) {
+        m_indexSize = static_cast<size_t>(size);
+
+        quint64 end = 0;
+
+        if (Size() > 0) {
+            quint64 lastOffset = 0;
+            quint32 lastSize   = 0;
+
+            ReadEntry(m_index + m_indexSize - EntrySize, lastOffset, lastSize);
+            end = lastOffset + lastSize;
+        }
+
+        ret = (std::memcmp(m_index, IndexMagic, 4) == 0) &&
+              (ReadUInt32(m_index + 4) == IndexVersion) &&
+              (ReadUInt32(m_index + 8) == EntrySize) &&
+              (end == static_cast<quint64>(m_dataFile.size()));
+
+        if (!ret) {
+            m_indexFile.unmap(const_cast<unsigned char*>(m_index));
+            m_index     = nullptr;
+            m_indexSize = 0;
+        }
+    }
+
+    return ret;
+}
+
+
+// recreates the index from the records in the data file
+bool MessageLibrary::Rebuild(void) {
+    bool ret = false;
+
+    Log("Info: MessageLibrary: Rebuilding the message index\n");
+
+    unsigned char header[IndexHeaderSize] = {0};
+
+    std::memcpy(header, IndexMagic, 4);
+    WriteUInt32(header + 4, IndexVersion);
+    WriteUInt32(header + 8, EntrySize);
+
+    if (m_indexFile.resize(0) &&
+        m_indexFile.seek(0) &&
+        (m_indexFile.write(reinterpret_cast<const char*>(header), sizeof(header)) == sizeof(header))) {
+        QByteArray data;
+        qint64     offset  = 0;
+        qint64     end     = 0; // of the last readable record
+        bool       damaged = false;
+
+        ret = m_dataFile.seek(0);
+
+        if (ret)
+            data = m_dataFile.readAll();
+
+        while (ret && (offset + 8 <= data.size())) {
+            const unsigned char* recordHeader = reinterpret_cast<const unsigned char*>(data.constData()) + offset;
+            quint32              size         = ReadUInt32(recordHeader + 4);
+            bool                 readable     = (std::memcmp(recordHeader, RecordMagic, 4) == 0) && (static_cast<qint64>(size) <= data.size() - offset - 8);
+            QString              name;
+
+            if (readable) {
+                QDataStream stream(data.mid(offset + 8, size));
+
+                stream.setVersion(QDataStream::Qt_6_0);
+                stream >> name;
+
+                readable = (stream.status() == QDataStream::Ok);
+            }
+
+            if (readable) {
+                unsigned char entry[EntrySize];
+
+                WriteEntry(entry, static_cast<quint64>(offset) + 8, size, name);
+
+                ret     = (m_indexFile.write(reinterpret_cast<const char*>(entry), EntrySize) == static_cast<qint64>(EntrySize));
+                offset += 8 + size;
+                end     = offset;
+            }
+            else {
+                // the messages behind a damaged record are kept, it is skipped up to the next record
+                qint64 next = data.indexOf(QByteArray::fromRawData(RecordMagic, 4), offset + 1);
+
+                damaged = true;
+                offset  = (next < 0) ? data.size() : next;
+            }
+        }
+
+        if (ret && damaged)
+            Log("Warning: MessageLibrary: Skipped damaged records in the message file\n");
+
+        // no message is behind the last readable record, e.g. an interrupted write
+        if (ret && (end < data.size())) {
+            Log("Warning: MessageLibrary: Dropping a damaged tail of the message file\n");
+            ret = m_dataFile.resize(end);
+        }
+
+        ret = ret && m_indexFile.flush() && Map();
+    }
+
+    if (!ret)
+        Log("Error: MessageLibrary::Rebuild(): Can not write the message index\n");
+
+    return ret;
+}
+
+
+bool MessageLibrary::AppendIndexEntry
+(
+    quint64        offset,
+    quint32        size,
+    const QString& name
+) {
+    bool          ret = false;
+    unsigned char entry[EntrySize];
+
+    WriteEntry(entry, offset, size, name);
+
+    // the mapping has to go before the file grows
+    if (m_index != nullptr) {
+        m_indexFile.unmap(const_cast<unsigned char*>(m_index));
+        m_index     = nullptr;
+        m_indexSize = 0;
+    }
+
+    if (m_indexFile.seek(m_indexFile.size()) &&
+        (m_indexFile.write(reinterpret_cast<const char*>(entry), EntrySize) == static_cast<qint64>(EntrySize)) &&
+        m_indexFile.flush())
+        ret = Map();
+
+    if (!ret)
+        ret = Rebuild();
+
+    return ret;
+}
+
+
+void MessageLibrary::Log
+(
+    const char* logString
+) const {
+    if (m_logHandler != nullptr)
+        (*m_logHandler)(logString);
+}
@@ -0,0 +1,79 @@
+/*                   M E S S A G E L I B R A R Y . H
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef MESSAGELIBRARY_INCLUDED
+#define MESSAGELIBRARY_INCLUDED
+
+#include <functional>
+#include <vector>
+
+#include <QFile>
+#include <QImage>
+#include <QString>
+
+
+// saved badge designs with their encoded payload and a thumbnail
+// The messages are appended to messages.dat, messages.idx holds a fixed size
+// entry with the name and the location of every message.  The index is
+// memory-mapped, searching it does not touch the messages.
+class MessageLibrary {
+public:
+    struct BankDesign {
+        QString text;
+        QString font;
+        bool    blinking       = false;
+        bool    animatedBorder = false;
+        int     mode           = 0;
+        int     speed          = 0;
+    };
+
+    struct Message {
+        QString                    name;
+        int                        brightness = 0;
+        BankDesign                 banks[8];
+        std::vector<unsigned char> payload;
+        QImage                     thumbnail;
+    };
+
+    MessageLibrary(std::function<void(const char* logString)>* logHandler = nullptr);
+    ~MessageLibrary(void);
+
+    bool                Open(const QString& directory);
+    size_t              Size(void) const;
+    QString             Name(size_t index) const;
+    std::vector<size_t> Search(const QString& pattern) const; // newest first
+    bool                Load(size_t   index,
+                             Message& message) const;
+    bool                Append(const Message& message);
+
+private:
+    std::function<void(const char* logString)>* m_logHandler;
+    mutable QFile                               m_dataFile;
+    QFile                                       m_indexFile;
+    const unsigned char*                        m_index;
+    size_t                                      m_indexSize;
+
+    bool Map(void);
+    bool Rebuild(void);
+    bool AppendIndexEntry(quint64        offset,
+                          quint32        size,
+                          const QString& name);
+    void Log(const char* logString) const;
+
+    MessageLibrary(const MessageLibrary&);            // not implemented
+    MessageLibrary& operator=(const MessageLibrary&); // not implemented
+};
+
+
+#endif // MESSAGELIBRARY_INCLUDED
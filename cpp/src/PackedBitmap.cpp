@@ -0,0 +1,260 @@
+/*                   P A C K E D B I T M A P . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+#include "PackedBitmap.h"
+
+
+// a 64 bit word holds the bytes of 8 rows of a byte column, every byte is a lane
+static const uint64_t Lanes = 0x0101010101010101ull;
+
+
+// shifts every lane by shift columns, positive to the right
+static inline uint64_t ShiftLanes
+(
+    uint64_t word,
+    int      shift
+) {
+    uint64_t ret = word;
+
+    if (shift > 0)
+        ret = (word >> shift) & (Lanes * (0xffu >> shift));
+    else if (shift < 0)
+        ret = (word << -shift) & (Lanes * ((0xffu << -shift) & 0xffu));
+
+    return ret;
+}
+
+
+template <class Operation>
+static inline uint64_t Combine
+(
+    uint64_t  destination,
+    uint64_t  bits,
+    uint64_t  coverage,
+    Operation operation
+) {
+    uint64_t ret = destination;
+
+    switch (operation) {
+        case Operation::Copy:
+            ret = (destination & ~coverage) | (bits & coverage);
+            break;
+
+        case Operation::Or:
+            ret = destination | (bits & coverage);
+            break;
+
+        case Operation::AndNot:
+            ret = destination & ~(bits & coverage);
+            break;
+
+        case Operation::Xor:
+            ret = destination ^ (bits & coverage);
+    }
+
+    return ret;
+}
+
+
+// combines a shifted source byte column with a destination byte column, 8 rows at once
+template <size_t Rows, class Operation>
+static inline void BlitByteColumn
+(
+    unsigned char*       destination,
+    const unsigned char* source,
+    int                  shift,
+    unsigned char        coverage,
+    Operation            operation
+) {
+    const uint64_t coverageWord = Lanes * coverage;
+    size_t         row          = 0;
+
+    for (; row + 8 <= Rows; row += 8) {
+        uint64_t sourceWord;
+        uint64_t destinationWord;
+
+        memcpy(&sourceWord, source + row, 8);
+        memcpy(&destinationWord, destination + row, 8);
+
+        destinationWord = Combine(destinationWord, ShiftLanes(sourceWord, shift), coverageWord, operation);
+
+        memcpy(destination + row, &destinationWord, 8);
+    }
+
+    for (; row < Rows; ++row)
+        destination[row] = static_cast<unsigned char>(Combine(destination[row], ShiftLanes(source[row], shift), coverage, operation));
+}
+
+
+template <class Geometry>
+BasicPackedBitmap<Geometry>::BasicPackedBitmap
+(
+    size_t width
+) : m_width(width), m_data(Rows * ((width + 7) / 8), '\x00') {}
+
+
+template <class Geometry>
+BasicPackedBitmap<Geometry>::BasicPackedBitmap
+(
+    size_t                                         width,
+    const std::function<bool(size_t x, size_t y)>& ledOn
+) : m_width(width), m_data(Rows * ((width + 7) / 8), '\x00') {
+    for (size_t x = 0; x < width; ++x) {
+        for (size_t y = 0; y < Rows; ++y) {
+            if (ledOn(x, y))
+                m_data[Rows * (x / 8) + y] |= 0x80 >> (x % 8);
+        }
+    }
+}
+
+
+template <class Geometry>
+BasicPackedBitmap<Geometry>::BasicPackedBitmap
+(
+    const unsigned char* data,
+    size_t               size,
+    size_t               width
+) : m_width(width), m_data(Rows * ((width + 7) / 8), '\x00') {
+    if (data != nullptr)
+        memcpy(m_data.data(), data, std::min(size, m_data.size()));
+
+    ClearPadding();
+}
+
+
+template <class Geometry>
+size_t BasicPackedBitmap<Geometry>::Width(void) const {
+    return m_width;
+}
+
+
+template <class Geometry>
+const std::vector<unsigned char>& BasicPackedBitmap<Geometry>::Data(void) const {
+    return m_data;
+}
+
+
+template <class Geometry>
+void BasicPackedBitmap<Geometry>::Resize
+(
+    size_t width
+) {
+    m_width = width;
+    m_data.resize(Rows * ((width + 7) / 8), '\x00');
+
+    ClearPadding();
+}
+
+
+template <class Geometry>
+void BasicPackedBitmap<Geometry>::Clear(void) {
+    std::fill(m_data.begin(), m_data.end(), '\x00');
+}
+
+
+template <class Geometry>
+bool BasicPackedBitmap<Geometry>::Get
+(
+    size_t x,
+    size_t y
+) const {
+    bool ret = false;
+
+    if ((x < m_width) && (y < Rows))
+        ret = (m_data[Rows * (x / 8) + y] & (0x80 >> (x % 8))) != 0;
+
+    return ret;
+}
+
+
+template <class Geometry>
+void BasicPackedBitmap<Geometry>::Set
+(
+    size_t x,
+    size_t y,
+    bool   on
+) {
+    if ((x < m_width) && (y < Rows)) {
+        unsigned char& byte = m_data[Rows * (x / 8) + y];
+
+        if (on)
+            byte |= 0x80 >> (x % 8);
+        else
+            byte &= ~(0x80 >> (x % 8));
+    }
+}
+
+
+template <class Geometry>
+void BasicPackedBitmap<Geometry>::Blit
+(
+    const BasicPackedBitmap& source,
+    size_t                   x,
+    Operation                operation
+) {
+    if ((x < m_width) && (source.m_width > 0)) {
+        int           shift             = static_cast<int>(x % 8);
+        size_t        firstByteColumn   = x / 8;
+        size_t        byteColumns       = m_data.size() / Rows;
+        size_t        sourceByteColumns = source.m_data.size() / Rows;
+        unsigned char lastCoverage      = (source.m_width % 8 == 0) ? 0xff : static_cast<unsigned char>(0xffu << (8 - source.m_width % 8));
+
+        // a source byte column touches two destination byte columns, unless it is aligned
+        for (size_t sourceByteColumn = 0; sourceByteColumn < sourceByteColumns; ++sourceByteColumn) {
+            size_t               byteColumn    = firstByteColumn + sourceByteColumn;
+            unsigned char        coverage      = (sourceByteColumn + 1 == sourceByteColumns) ? lastCoverage : 0xff;
+            const unsigned char* sourceColumn  = source.m_data.data() + Rows * sourceByteColumn;
+
+            if (byteColumn >= byteColumns)
+                break;
+
+            BlitByteColumn<Rows>(m_data.data() + Rows * byteColumn, sourceColumn, shift, coverage >> shift, operation);
+
+            if ((shift > 0) && (byteColumn + 1 < byteColumns))
+                BlitByteColumn<Rows>(m_data.data() + Rows * (byteColumn + 1), sourceColumn, shift - 8, static_cast<unsigned char>(coverage << (8 - shift)), operation);
+        }
+
+        ClearPadding();
+    }
+}
+
+
+template <class Geometry>
+bool BasicPackedBitmap<Geometry>::Store
+(
+    typename BasicLedBadge<Geometry>::MemoryBank memoryBank
+) const {
+    return memoryBank.SetPackedData(m_data.data(), m_data.size());
+}
+
+
+template <class Geometry>
+void BasicPackedBitmap<Geometry>::ClearPadding(void) {
+    if ((m_width % 8) != 0) {
+        unsigned char  mask       = static_cast<unsigned char>(0xffu << (8 - m_width % 8));
+        unsigned char* lastColumn = m_data.data() + m_data.size() - Rows;
+
+        for (size_t row = 0; row < Rows; ++row)
+            lastColumn[row] &= mask;
+    }
+}
+
+
+template class BasicPackedBitmap<Geometry11x44>;
+template class BasicPackedBitmap<Geometry12x48>;
+template class BasicPackedBitmap<Geometry16x64>;
@@ -0,0 +1,81 @@
+/*                     P A C K E D B I T M A P . H
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef PACKEDBITMAP_INCLUDED
+#define PACKEDBITMAP_INCLUDED
+
+#include <functional>
+#include <vector>
+
+#include "LedBadge.h"
+
+
+// bank content in the encoded format of the badge: Rows bytes per 8 columns,
+// the leftmost column in the most significant bit
+// The blits combine bitmaps at any column offset without decoding them,
+// the bits right of the width are always 0.
+template <class Geometry = Geometry11x44>
+class BasicPackedBitmap {
+public:
+    static constexpr size_t Rows = Geometry::Rows;
+
+    enum class Operation {
+        Copy,   // destination = source
+        Or,     // destination |= source
+        AndNot, // destination &= ~source
+        Xor     // destination ^= source
+    };
+
+    BasicPackedBitmap(size_t width = 0);
+    BasicPackedBitmap(size_t                                         width,
+                      const std::function<bool(size_t x, size_t y)>& ledOn);
+    BasicPackedBitmap(const unsigned char* data,
+                      size_t               size,
+                      size_t               width);
+
+    size_t                            Width(void) const;
+    const std::vector<unsigned char>& Data(void) const;
+
+    void Resize(size_t width);
+    void Clear(void);
+    bool Get(size_t x,
+             size_t y) const;
+    void Set(size_t x,
+             size_t y,
+             bool   on);
+
+    // the source's column 0 goes to column x, clipped to the width
+    void Blit(const BasicPackedBitmap& source,
+              size_t                   x,
+              Operation                operation = Operation::Or);
+
+    bool Store(typename BasicLedBadge<Geometry>::MemoryBank memoryBank) const;
+
+private:
+    size_t                     m_width;
+    std::vector<unsigned char> m_data;
+
+    void ClearPadding(void);
+};
+
+
+extern template class BasicPackedBitmap<Geometry11x44>;
+extern template class BasicPackedBitmap<Geometry12x48>;
+extern template class BasicPackedBitmap<Geometry16x64>;
+
+
+typedef BasicPackedBitmap<> PackedBitmap;
+
+
+#endif // PACKEDBITMAP_INCLUDED
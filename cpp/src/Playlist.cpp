@@ -0,0 +1,261 @@
+/*                       P L A Y L I S T . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <thread>
+
+#include "Playlist.h"
+
+
+Playlist::Playlist
+(
+    std::function<void(const char* logString)>* logHandler
+) : m_logHandler(logHandler), m_period(0), m_entries(), m_mutex(), m_wakeUp(), m_stopped(false) {}
+
+
+void Playlist::SetPeriod
+(
+    std::chrono::milliseconds period
+) {
+    m_period = period;
+}
+
+
+bool Playlist::AddEntry
+(
+    std::chrono::milliseconds start,
+    const LedBadge&           content
+) {
+    std::vector<unsigned char> payload;
+    bool                       ret = content.FetchData(payload);
+
+    if (ret)
+        ret = AddEntry(start, payload);
+
+    return ret;
+}
+
+
+bool Playlist::AddEntry
+(
+    std::chrono::milliseconds         start,
+    const std::vector<unsigned char>& payload
+) {
+    bool ret = false;
+
+    if (payload.size() >= LedBadge::HeaderSize) {
+        Entry                        entry = {start, payload};
+        std::vector<Entry>::iterator position = std::upper_bound(m_entries.begin(), m_entries.end(), entry,
+                                                                 [](const Entry& a, const Entry& b){return a.start < b.start;});
+
+        m_entries.insert(position, entry);
+        ret = true;
+    }
+    else
+        Log("Error: Playlist::AddEntry(): The payload is too small to hold a header\n");
+
+    return ret;
+}
+
+
+bool Playlist::Load
+(
+    const char* fileName
+) {
+    bool          ret = true;
+    std::ifstream timeline(fileName);
+
+    if (timeline) {
+        std::string fileNameString(fileName);
+        std::string directory;
+        size_t      separator = fileNameString.rfind('/');
+
+        if (separator != std::string::npos)
+            directory = fileNameString.substr(0, separator + 1);
+
+        std::string line;
+        size_t      lineNumber = 0;
+
+        while (ret && std::getline(timeline, line)) {
+            ++lineNumber;
+
+            std::istringstream lineStream(line);
+            std::string        first;
+            std::string        payloadFileName;
+
+            if (!(lineStream >> first) || (first[0] == '#'))
+                continue;
+
+            if (first == "period") {
+                double period = 0.;
+
+                if (lineStream >> period)
+                    SetPeriod(std::chrono::milliseconds(static_cast<long long>(period * 1000.)));
+                else
+                    ret = false;
+            }
+            else {
+                std::istringstream startStream(first);
+                double             start = 0.;
+
+                if ((startStream >> start) && (lineStream >> payloadFileName)) {
+                    if (payloadFileName[0] != '/')
+                        payloadFileName = directory + payloadFileName;
+
+                    std::ifstream payloadFile(payloadFileName, std::ios::binary);
+
+                    if (payloadFile) {
+                        std::vector<unsigned char> payload((std::istreambuf_iterator<char>(payloadFile)), std::istreambuf_iterator<char>());
+
+                        ret = AddEntry(std::chrono::milliseconds(static_cast<long long>(start * 1000.)), payload);
+                    }
+                    else {
+                        std::stringstream logstream;
+                        logstream << "Error: Playlist::Load(): Cannot read " << payloadFileName << "\n";
+                        Log(logstream.str().c_str());
+                        ret = false;
+                    }
+                }
+                else
+                    ret = false;
+            }
+
+            if (!ret) {
+                std::stringstream logstream;
+                logstream << "Error: Playlist::Load(): " << fileName << ":" << lineNumber << ": Invalid entry\n";
+                Log(logstream.str().c_str());
+            }
+        }
+    }
+    else {
+        std::stringstream logstream;
+        logstream << "Error: Playlist::Load(): Cannot read " << fileName << "\n";
+        Log(logstream.str().c_str());
+        ret = false;
+    }
+
+    return ret;
+}
+
+
+bool Playlist::Run
+(
+    const UsbTransferOptions& options,
+    size_t                    cycles,
+    PlaylistStatistics*       statistics
+) {
+    bool               ret = true;
+    PlaylistStatistics runStatistics;
+    double             jitterSum = 0.;
+
+    if (m_entries.size() == 0) {
+        Log("Error: Playlist::Run(): The playlist is empty\n");
+        ret = false;
+    }
+    else if ((m_period.count() > 0) && (m_entries.back().start >= m_period)) {
+        Log("Error: Playlist::Run(): An entry starts after the end of the period\n");
+        ret = false;
+    }
+
+    if (ret) {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            m_stopped = false;
+        }
+
+        std::chrono::steady_clock::time_point runStart      = std::chrono::steady_clock::now();
+        bool                                  stopped       = false;
+        UsbTransferOptions                    uploadOptions = options;
+
+        uploadOptions.synchronizeClock = true;
+
+        for (size_t cycle = 0; !stopped && ((cycles == 0) || (cycle < cycles)); ++cycle) {
+            for (Entry& entry : m_entries) {
+                std::chrono::steady_clock::time_point target = runStart + cycle * m_period + entry.start;
+
+                {
+                    // wake up a bit early, the last millisecond is waited for actively
+                    std::unique_lock<std::mutex> lock(m_mutex);
+
+                    stopped = m_wakeUp.wait_until(lock, target - std::chrono::milliseconds(1), [this](){return m_stopped;});
+                }
+
+                if (stopped)
+                    break;
+
+                while (std::chrono::steady_clock::now() < target)
+                    std::this_thread::yield();
+
+                double jitter = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - target).count();
+
+                if (SendToUsb(entry.payload, m_logHandler, nullptr, uploadOptions))
+                    ++runStatistics.uploads;
+                else
+                    ++runStatistics.failures;
+
+                jitterSum               += jitter;
+                runStatistics.maxJitter  = std::max(runStatistics.maxJitter, jitter);
+
+                std::stringstream logstream;
+                logstream << "Info: Playlist::Run(): Entry at " << entry.start.count() / 1000. << " s of cycle " << cycle
+                          << " started " << jitter << " ms late\n";
+                Log(logstream.str().c_str());
+            }
+
+            if (m_period.count() == 0)
+                break;
+        }
+
+        size_t started = runStatistics.uploads + runStatistics.failures;
+
+        if (started > 0)
+            runStatistics.meanJitter = jitterSum / started;
+
+        std::stringstream logstream;
+        logstream << "Info: Playlist::Run(): " << runStatistics.uploads << " uploads, " << runStatistics.failures << " failures, start jitter mean "
+                  << runStatistics.meanJitter << " ms, max " << runStatistics.maxJitter << " ms\n";
+        Log(logstream.str().c_str());
+
+        ret = (runStatistics.failures == 0);
+    }
+
+    if (statistics != nullptr)
+        *statistics = runStatistics;
+
+    return ret;
+}
+
+
+void Playlist::Stop(void) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_stopped = true;
+    }
+
+    m_wakeUp.notify_all();
+}
+
+
+void Playlist::Log
+(
+    const char* logString
+) const {
+    if (m_logHandler != nullptr)
+        (*m_logHandler)(logString);
+}
@@ -0,0 +1,77 @@
+/*                         P L A Y L I S T . H
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef PLAYLIST_INCLUDED
+#define PLAYLIST_INCLUDED
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <vector>
+
+#include "LedBadge.h"
+#include "usb.h"
+
+
+struct PlaylistStatistics {
+    size_t uploads    = 0;
+    size_t failures   = 0;
+    double meanJitter = 0.; // in ms, of the upload starts
+    double maxJitter  = 0.; // in ms
+};
+
+
+// sends precomputed payloads on a schedule
+// The entries are encoded when they are added, only the clock fields are set
+// by SendToUsb() when an entry is sent.  The start times are relative to the start of
+// Run() and repeat every period.
+class Playlist {
+public:
+    Playlist(std::function<void(const char* logString)>* logHandler = nullptr);
+
+    void SetPeriod(std::chrono::milliseconds period); // 0 plays the entries once
+    bool AddEntry(std::chrono::milliseconds start,
+                  const LedBadge&           content);
+    bool AddEntry(std::chrono::milliseconds         start,
+                  const std::vector<unsigned char>& payload);
+
+    // reads a timeline file with lines "<start in s> <payload file>" and
+    // optionally "period <s>", payload files are fetched data and relative to
+    // the timeline file
+    bool Load(const char* fileName);
+
+    bool Run(const UsbTransferOptions& options    = UsbTransferOptions(),
+             size_t                    cycles     = 0, // 0 runs until Stop()
+             PlaylistStatistics*       statistics = nullptr);
+    void Stop(void);
+
+private:
+    struct Entry {
+        std::chrono::milliseconds  start;
+        std::vector<unsigned char> payload;
+    };
+
+    std::function<void(const char* logString)>* m_logHandler;
+    std::chrono::milliseconds                   m_period;
+    std::vector<Entry>                          m_entries;
+    std::mutex                                  m_mutex;
+    std::condition_variable                     m_wakeUp;
+    bool                                        m_stopped;
+
+    void Log(const char* logString) const;
+};
+
+
+#endif // PLAYLIST_INCLUDED
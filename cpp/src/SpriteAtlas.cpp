@@ -0,0 +1,223 @@
+/*                    S P R I T E A T L A S . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <vector>
+
+#include "SpriteAtlas.h"
+
+
+static const char Magic[4] = {'L', 'B', 'S', 'A'};
+
+
+static bool ReadUInt16
+(
+    const std::vector<unsigned char>& buffer,
+    size_t&                           position,
+    size_t&                           value
+) {
+    bool ret = false;
+
+    if (position + 2 <= buffer.size()) {
+        value     = buffer[position] | (buffer[position + 1] << 8);
+        position += 2;
+        ret       = true;
+    }
+
+    return ret;
+}
+
+
+static void WriteUInt16
+(
+    std::ofstream& file,
+    size_t         value
+) {
+    file.put(static_cast<char>(value & 0xff));
+    file.put(static_cast<char>((value >> 8) & 0xff));
+}
+
+
+template <class Geometry>
+BasicSpriteAtlas<Geometry>::BasicSpriteAtlas
+(
+    std::function<void(const char* logString)>* logHandler
+) : m_logHandler(logHandler), m_sprites() {}
+
+
+template <class Geometry>
+void BasicSpriteAtlas<Geometry>::Add
+(
+    const std::string&                 name,
+    const BasicPackedBitmap<Geometry>& sprite
+) {
+    m_sprites.insert_or_assign(name, sprite);
+}
+
+
+template <class Geometry>
+const BasicPackedBitmap<Geometry>* BasicSpriteAtlas<Geometry>::Find
+(
+    const std::string& name
+) const {
+    const BasicPackedBitmap<Geometry>*                                          ret    = nullptr;
+    typename std::map<std::string, BasicPackedBitmap<Geometry>>::const_iterator sprite = m_sprites.find(name);
+
+    if (sprite != m_sprites.end())
+        ret = &sprite->second;
+
+    return ret;
+}
+
+
+template <class Geometry>
+size_t BasicSpriteAtlas<Geometry>::Size(void) const {
+    return m_sprites.size();
+}
+
+
+template <class Geometry>
+bool BasicSpriteAtlas<Geometry>::Load
+(
+    const char* fileName
+) {
+    bool          ret = false;
+    std::ifstream file(fileName, std::ios::binary);
+
+    if (file) {
+        std::vector<unsigned char> buffer((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        size_t                     position = sizeof(Magic) + 1;
+
+        if ((buffer.size() >= position) && std::equal(Magic, Magic + sizeof(Magic), buffer.begin()) && (buffer[sizeof(Magic)] == Geometry::Rows)) {
+            std::map<std::string, BasicPackedBitmap<Geometry>> sprites;
+
+            ret = true;
+
+            while (ret && (position < buffer.size())) {
+                size_t nameLength = 0;
+                size_t width      = 0;
+
+                ret = ReadUInt16(buffer, position, nameLength) && (position + nameLength <= buffer.size());
+
+                if (ret) {
+                    std::string name(buffer.begin() + position, buffer.begin() + position + nameLength);
+
+                    position += nameLength;
+                    ret       = ReadUInt16(buffer, position, width);
+
+                    if (ret) {
+                        size_t size = Geometry::Rows * ((width + 7) / 8);
+
+                        ret = (position + size <= buffer.size());
+
+                        if (ret) {
+                            sprites.insert_or_assign(name, BasicPackedBitmap<Geometry>(buffer.data() + position, size, width));
+                            position += size;
+                        }
+                    }
+                }
+            }
+
+            // the loaded sprites replace the ones with the same name
+            if (ret) {
+                for (const std::pair<const std::string, BasicPackedBitmap<Geometry>>& sprite : sprites)
+                    m_sprites.insert_or_assign(sprite.first, sprite.second);
+            }
+            else {
+                std::stringstream logstream;
+                logstream << "Error: SpriteAtlas::Load(): " << fileName << " is truncated\n";
+                Log(logstream.str().c_str());
+            }
+        }
+        else {
+            std::stringstream logstream;
+            logstream << "Error: SpriteAtlas::Load(): " << fileName << " is no sprite atlas for " << Geometry::Rows << " rows\n";
+            Log(logstream.str().c_str());
+        }
+    }
+    else {
+        std::stringstream logstream;
+        logstream << "Error: SpriteAtlas::Load(): Cannot read " << fileName << "\n";
+        Log(logstream.str().c_str());
+    }
+
+    return ret;
+}
+
+
+// written to a temporary file which replaces the old one when it is complete
+template <class Geometry>
+bool BasicSpriteAtlas<Geometry>::Save
+(
+    const char* fileName
+) const {
+    bool        ret           = true;
+    std::string temporaryName = std::string(fileName) + ".tmp";
+
+    for (const std::pair<const std::string, BasicPackedBitmap<Geometry>>& sprite : m_sprites) {
+        if ((sprite.first.size() > 0xffff) || (sprite.second.Width() > 0xffff)) {
+            std::stringstream logstream;
+            logstream << "Error: SpriteAtlas::Save(): Sprite " << sprite.first << " is too large\n";
+            Log(logstream.str().c_str());
+            ret = false;
+            break;
+        }
+    }
+
+    if (ret) {
+        std::ofstream file(temporaryName, std::ios::binary | std::ios::trunc);
+
+        file.write(Magic, sizeof(Magic));
+        file.put(static_cast<char>(Geometry::Rows));
+
+        for (const std::pair<const std::string, BasicPackedBitmap<Geometry>>& sprite : m_sprites) {
+            WriteUInt16(file, sprite.first.size());
+            file.write(sprite.first.data(), sprite.first.size());
+            WriteUInt16(file, sprite.second.Width());
+            file.write(reinterpret_cast<const char*>(sprite.second.Data().data()), sprite.second.Data().size());
+        }
+
+        file.close();
+
+        ret = !file.fail() && (std::rename(temporaryName.c_str(), fileName) == 0);
+
+        if (!ret) {
+            std::remove(temporaryName.c_str());
+
+            std::stringstream logstream;
+            logstream << "Error: SpriteAtlas::Save(): Cannot write " << fileName << "\n";
+            Log(logstream.str().c_str());
+        }
+    }
+
+    return ret;
+}
+
+
+template <class Geometry>
+void BasicSpriteAtlas<Geometry>::Log
+(
+    const char* logString
+) const {
+    if (m_logHandler != nullptr)
+        (*m_logHandler)(logString);
+}
+
+
+template class BasicSpriteAtlas<Geometry11x44>;
+template class BasicSpriteAtlas<Geometry12x48>;
+template class BasicSpriteAtlas<Geometry16x64>;
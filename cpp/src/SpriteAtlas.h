@@ -0,0 +1,58 @@
+/*                      S P R I T E A T L A S . H
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef SPRITEATLAS_INCLUDED
+#define SPRITEATLAS_INCLUDED
+
+#include <functional>
+#include <map>
+#include <string>
+
+#include "PackedBitmap.h"
+
+
+// named, already encoded icons, e.g. to be blitted into a PackedBitmap
+// The file starts with "LBSA" and the number of rows, followed by the
+// sprites: name length (2 bytes, little endian), name, width (2 bytes, little
+// endian) and the packed data.
+template <class Geometry = Geometry11x44>
+class BasicSpriteAtlas {
+public:
+    BasicSpriteAtlas(std::function<void(const char* logString)>* logHandler = nullptr);
+
+    void                                 Add(const std::string&                 name,
+                                             const BasicPackedBitmap<Geometry>& sprite);
+    const BasicPackedBitmap<Geometry>*   Find(const std::string& name) const; // nullptr if unknown
+    size_t                               Size(void) const;
+
+    bool                                 Load(const char* fileName); // replaces the sprites with the same names
+    bool                                 Save(const char* fileName) const;
+
+private:
+    std::function<void(const char* logString)>*        m_logHandler;
+    std::map<std::string, BasicPackedBitmap<Geometry>> m_sprites;
+
+    void Log(const char* logString) const;
+};
+
+
+extern template class BasicSpriteAtlas<Geometry11x44>;
+extern template class BasicSpriteAtlas<Geometry12x48>;
+extern template class BasicSpriteAtlas<Geometry16x64>;
+
+
+typedef BasicSpriteAtlas<> SpriteAtlas;
+
+
+#endif // SPRITEATLAS_INCLUDED
@@ -0,0 +1,58 @@
+/*                   T E X T R E N D E R E R . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <algorithm>
+
+#include <QFontMetrics>
+#include <QPainter>
+
+#include "TextRenderer.h"
+
+
+QImage RenderText
+(
+    const QString& text,
+    const QFont&   font,
+    size_t         height
+) {
+    QFont renderFont(font);
+    renderFont.setStyleStrategy(QFont::NoAntialias);
+
+    QFontMetrics metrics(renderFont);
+    int          width = std::max(metrics.horizontalAdvance(text), 1);
+    QImage       image(width, static_cast<int>(height), QImage::Format_RGB32);
+
+    image.fill(Qt::white);
+
+    if (!text.isEmpty()) {
+        QPainter painter(&image);
+
+        painter.setFont(renderFont);
+        painter.setPen(Qt::black);
+        painter.drawText(image.rect(), Qt::AlignLeft | Qt::AlignVCenter, text);
+    }
+
+    return image;
+}
+
+
+bool LedOn
+(
+    const QImage& image,
+    size_t        x,
+    size_t        y,
+    double        threshold
+) {
+    return (image.pixelColor(x, y).valueF() > threshold) ? false : true;
+}
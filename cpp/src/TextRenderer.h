@@ -0,0 +1,41 @@
+/*                     T E X T R E N D E R E R . H
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef TEXTRENDERER_INCLUDED
+#define TEXTRENDERER_INCLUDED
+
+#include <QFont>
+#include <QImage>
+#include <QString>
+
+
+// renders the text the same way for the preview and for the badge
+QImage RenderText
+(
+    const QString& text,
+    const QFont&   font,
+    size_t         height = 11
+);
+
+
+bool LedOn
+(
+    const QImage& image,
+    size_t        x,
+    size_t        y,
+    double        threshold = 0.7
+);
+
+
+#endif // TEXTRENDERER_INCLUDED
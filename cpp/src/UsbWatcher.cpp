@@ -0,0 +1,209 @@
+/*                     U S B W A T C H E R . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#include <sstream>
+
+#include "UsbWatcher.h"
+
+
+static double Milliseconds
+(
+    std::chrono::steady_clock::duration duration
+) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+
+UsbWatcher::UsbWatcher
+(
+    std::function<void(const char* logString)>* logHandler
+) : m_logHandler(logHandler), m_timelineHandler(nullptr), m_mutex(), m_wakeUp(), m_thread(), m_running(false),
+    m_lifecycleMutex(), m_payload(), m_armed(false), m_startTime() {}
+
+
+UsbWatcher::~UsbWatcher(void) {
+    Stop();
+}
+
+
+void UsbWatcher::SetTimelineHandler
+(
+    std::function<void(const UsbDeviceTimeline& timeline)>* timelineHandler
+) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_timelineHandler = timelineHandler;
+}
+
+
+void UsbWatcher::Arm
+(
+    const std::vector<unsigned char>& data
+) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_payload = data;
+    m_armed   = true;
+}
+
+
+void UsbWatcher::Disarm(void) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    m_payload.clear();
+    m_armed = false;
+}
+
+
+bool UsbWatcher::Start
+(
+    unsigned int pollInterval
+) {
+    bool                        ret = false;
+    std::lock_guard<std::mutex> lifecycleLock(m_lifecycleMutex);
+
+    if (!m_thread.joinable()) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_running   = true;
+        m_startTime = std::chrono::steady_clock::now();
+        m_thread    = std::thread(&UsbWatcher::Run, this, pollInterval);
+        ret         = true;
+    }
+
+    return ret;
+}
+
+
+void UsbWatcher::Stop(void) {
+    std::lock_guard<std::mutex> lifecycleLock(m_lifecycleMutex);
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        m_running = false;
+    }
+
+    m_wakeUp.notify_all();
+
+    if (m_thread.joinable())
+        m_thread.join();
+}
+
+
+bool UsbWatcher::IsRunning(void) const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+
+    return m_running;
+}
+
+
+void UsbWatcher::Run
+(
+    unsigned int pollInterval
+) {
+    std::vector<std::string> initialDevices = EnumerateUsbBadges(m_logHandler);
+    std::set<std::string>    knownDevices(initialDevices.begin(), initialDevices.end());
+
+    Log("Info: UsbWatcher: Watching for LED badges\n");
+
+    for (;;) {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+
+            m_wakeUp.wait_for(lock, std::chrono::milliseconds(pollInterval), [this](){return !m_running;});
+
+            if (!m_running)
+                break;
+        }
+
+        std::vector<std::string>              devices  = EnumerateUsbBadges(m_logHandler);
+        std::chrono::steady_clock::time_point detected = std::chrono::steady_clock::now();
+        std::set<std::string>                 currentDevices(devices.begin(), devices.end());
+
+        for (const std::string& devicePath : currentDevices) {
+            if (knownDevices.find(devicePath) == knownDevices.end())
+                Push(devicePath, detected);
+        }
+
+        // removed badges are pushed to again when they are reattached
+        knownDevices.swap(currentDevices);
+    }
+
+    Log("Info: UsbWatcher: Stopped watching for LED badges\n");
+}
+
+
+void UsbWatcher::Push
+(
+    const std::string&                    devicePath,
+    std::chrono::steady_clock::time_point detected
+) {
+    std::vector<unsigned char> payload;
+    bool                       armed = false;
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+
+        payload = m_payload;
+        armed   = m_armed;
+    }
+
+    std::stringstream logstream;
+    logstream << "Info: UsbWatcher: " << devicePath << ": attached at +" << Milliseconds(detected - m_startTime) / 1000. << " s\n";
+    Log(logstream.str().c_str());
+
+    if (armed) {
+        UsbDeviceTimeline  timeline;
+        UsbTransferOptions options;
+
+        options.devicePath       = devicePath.c_str();
+        options.synchronizeClock = true;
+
+        timeline.devicePath     = devicePath;
+        timeline.detected       = detected;
+        timeline.uploadStarted  = std::chrono::steady_clock::now();
+        timeline.success        = SendToUsb(payload, m_logHandler, &timeline.statistics, options);
+        timeline.uploadFinished = std::chrono::steady_clock::now();
+
+        std::stringstream timelinestream;
+        timelinestream << "Info: UsbWatcher: " << devicePath << ": upload started after " << Milliseconds(timeline.uploadStarted - detected)
+                       << " ms, " << (timeline.success ? "finished" : "failed") << " after " << Milliseconds(timeline.uploadFinished - detected)
+                       << " ms (" << timeline.statistics.retries << " retries, " << timeline.statistics.restarts << " restarts)\n";
+        Log(timelinestream.str().c_str());
+
+        std::function<void(const UsbDeviceTimeline& timeline)>* timelineHandler = nullptr;
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+
+            timelineHandler = m_timelineHandler;
+        }
+
+        // without the lock, the handler may Arm() or Disarm()
+        if (timelineHandler != nullptr)
+            (*timelineHandler)(timeline);
+    }
+    else
+        Log("Warning: UsbWatcher: No payload armed, the badge was not programmed\n");
+}
+
+
+void UsbWatcher::Log
+(
+    const char* logString
+) const {
+    if (m_logHandler != nullptr)
+        (*m_logHandler)(logString);
+}
@@ -0,0 +1,82 @@
+/*                       U S B W A T C H E R . H
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+#ifndef USBWATCHER_INCLUDED
+#define USBWATCHER_INCLUDED
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "usb.h"
+
+
+struct UsbDeviceTimeline {
+    std::string                           devicePath;
+    std::chrono::steady_clock::time_point detected;
+    std::chrono::steady_clock::time_point uploadStarted;
+    std::chrono::steady_clock::time_point uploadFinished;
+    bool                                  success = false;
+    UsbTransferStatistics                 statistics;
+};
+
+
+// watches for LED badges being attached and pushes the armed payload to each
+// new badge
+// The watcher enumerates the devices in the background, the badges which are
+// connected when it starts are not pushed to.  The handlers are called from
+// the background thread without a lock held, they may Arm() or Disarm() but
+// not Start() or Stop().
+class UsbWatcher {
+public:
+    UsbWatcher(std::function<void(const char* logString)>* logHandler = nullptr);
+    ~UsbWatcher(void);
+
+    void SetTimelineHandler(std::function<void(const UsbDeviceTimeline& timeline)>* timelineHandler);
+
+    void Arm(const std::vector<unsigned char>& data);
+    void Disarm(void);
+
+    bool Start(unsigned int pollInterval = 250); // in ms
+    void Stop(void);
+    bool IsRunning(void) const;
+
+private:
+    std::function<void(const char* logString)>*             m_logHandler;
+    std::function<void(const UsbDeviceTimeline& timeline)>* m_timelineHandler;
+    mutable std::mutex                                      m_mutex;
+    std::condition_variable                                 m_wakeUp;
+    std::thread                                             m_thread;
+    bool                                                    m_running;
+    std::mutex                                              m_lifecycleMutex; // serializes Start() and Stop() on m_thread
+    std::vector<unsigned char>                              m_payload;
+    bool                                                    m_armed;
+    std::chrono::steady_clock::time_point                   m_startTime;
+
+    void Run(unsigned int pollInterval);
+    void Push(const std::string&                    devicePath,
+              std::chrono::steady_clock::time_point detected);
+    void Log(const char* logString) const;
+
+    UsbWatcher(const UsbWatcher&);            // not implemented
+    UsbWatcher& operator=(const UsbWatcher&); // not implemented
+};
+
+
+#endif // USBWATCHER_INCLUDED
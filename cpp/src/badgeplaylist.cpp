@@ -0,0 +1,83 @@
+/*                  B A D G E P L A Y L I S T . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// sends the payloads of a timeline file on schedule
+// usage: playlist [-b hidapi|hidraw|simulated] [-n cycles] timeline
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+#include <pthread.h>
+
+#include "Playlist.h"
+
+
+int main
+(
+    int    argc,
+    char** argv
+) {
+    std::function<void(const char* logString)> logHandler = [](const char* logString){std::cerr << logString;};
+    UsbTransferOptions                         options;
+    size_t                                     cycles       = 0;
+    const char*                                timelineFile = nullptr;
+    bool                                       usage        = false;
+
+    for (int i = 1; !usage && (i < argc); ++i) {
+        if ((strcmp(argv[i], "-b") == 0) && (i + 1 < argc))
+            usage = !ParseUsbBackend(argv[++i], options.backend);
+        else if ((strcmp(argv[i], "-n") == 0) && (i + 1 < argc))
+            cycles = strtoul(argv[++i], nullptr, 10);
+        else if (timelineFile == nullptr)
+            timelineFile = argv[i];
+        else
+            usage = true;
+    }
+
+    if (usage || (timelineFile == nullptr)) {
+        std::cerr << "usage: " << argv[0] << " [-b hidapi|hidraw|simulated] [-n cycles] timeline\n";
+        return EXIT_FAILURE;
+    }
+
+    Playlist playlist(&logHandler);
+
+    if (!playlist.Load(timelineFile))
+        return EXIT_FAILURE;
+
+    // Stop() is not async-signal-safe, so SIGINT and SIGTERM are taken by a
+    // thread of their own and the transfer in progress is finished
+    sigset_t stopSignals;
+
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    std::thread signalWaiter([&playlist, &stopSignals]() {
+        int signalNumber = 0;
+
+        sigwait(&stopSignals, &signalNumber);
+        playlist.Stop();
+    });
+
+    bool ok = playlist.Run(options, cycles);
+
+    pthread_kill(signalWaiter.native_handle(), SIGTERM); // after the last cycle
+    signalWaiter.join();
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,130 @@
+/*                     B A D G E W A T C H . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// sends the badge again whenever one of its source files changes
+// usage: badgewatch [-b hidapi|hidraw|simulated] [-d debounce in ms] [-f font] bank=file ...
+// *.txt files are rendered as text, *.pbm files are bitmaps, other files are
+// payloads or packed bank data
+
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include <QFile>
+#include <QFont>
+#include <QGuiApplication>
+
+#include "FileWatch.h"
+#include "TextRenderer.h"
+
+
+static const double Threshold = 0.7;
+static FileWatch*   Watch     = nullptr;
+
+
+static void StopWatch
+(
+    int /* signal */
+) {
+    if (Watch != nullptr)
+        Watch->Stop();
+}
+
+
+static bool EndsWith
+(
+    const std::string& text,
+    const char*        end
+) {
+    size_t size = strlen(end);
+
+    return (text.size() >= size) && (text.compare(text.size() - size, size, end) == 0);
+}
+
+
+int main
+(
+    int    argc,
+    char** argv
+) {
+    // for the fonts only, so no display is needed
+    setenv("QT_QPA_PLATFORM", "offscreen", 0);
+
+    QGuiApplication application(argc, argv);
+
+    std::function<void(const char* logString)> logHandler = [](const char* logString){std::cerr << logString;};
+    FileWatch                                  fileWatch(&logHandler);
+    UsbTransferOptions                         options;
+    QFont                                      font;
+    size_t                                     sources = 0;
+    bool                                       usage   = false;
+
+    font.setStyleStrategy(QFont::NoAntialias);
+
+    FileWatch::Loader textLoader = [&font](const std::string& fileName, size_t /* index */, LedBadge::MemoryBank memoryBank) {
+        bool  ret = false;
+        QFile file(QString::fromStdString(fileName));
+
+        if (file.open(QIODevice::ReadOnly)) {
+            QImage image = RenderText(QString::fromUtf8(file.readAll()).simplified(), font, LedBadge::Rows);
+
+            ret = memoryBank.SetData(image.width(), [&image](size_t x, size_t y) {return LedOn(image, x, y, Threshold);});
+        }
+
+        return ret;
+    };
+
+    for (int i = 1; !usage && (i < argc); ++i) {
+        if ((strcmp(argv[i], "-b") == 0) && (i + 1 < argc))
+            usage = !ParseUsbBackend(argv[++i], options.backend);
+        else if ((strcmp(argv[i], "-d") == 0) && (i + 1 < argc))
+            fileWatch.SetDebounce(std::chrono::milliseconds(strtoul(argv[++i], nullptr, 10)));
+        else if ((strcmp(argv[i], "-f") == 0) && (i + 1 < argc)) {
+            usage = !font.fromString(QString::fromLocal8Bit(argv[++i]));
+            font.setStyleStrategy(QFont::NoAntialias);
+        }
+        else {
+            char*       separator = strchr(argv[i], '=');
+            size_t      bank      = strtoul(argv[i], nullptr, 10);
+            std::string fileName  = (separator != nullptr) ? separator + 1 : "";
+
+            if ((separator == nullptr) || (bank < 1) || (bank > LedBadge::Banks) || fileName.empty())
+                usage = true;
+            else if (EndsWith(fileName, ".txt"))
+                usage = !fileWatch.AddSource(bank - 1, fileName, textLoader);
+            else if (EndsWith(fileName, ".pbm"))
+                usage = !fileWatch.AddSource(bank - 1, fileName, FileWatch::LoadBitmap);
+            else
+                usage = !fileWatch.AddSource(bank - 1, fileName, FileWatch::LoadPackedData);
+
+            ++sources;
+        }
+    }
+
+    if (usage || (sources == 0)) {
+        std::cerr << "usage: " << argv[0] << " [-b hidapi|hidraw|simulated] [-d debounce in ms] [-f font] bank=file ...\n";
+        return EXIT_FAILURE;
+    }
+
+    Watch = &fileWatch;
+    signal(SIGINT, StopWatch);
+    signal(SIGTERM, StopWatch);
+
+    bool ok = fileWatch.Run(options);
+
+    Watch = nullptr;
+
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -12,13 +12,45 @@
  * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
  */
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <mutex>
 #include <sstream>
+#include <thread>
+
+#ifdef LEDBADGE_WITH_HIDRAW
+#   include <filesystem>
+
+#   include <fcntl.h>
+#   include <unistd.h>
+#endif
 
 #include "hidapi.h"
 
+#include "LedBadge.h"
 #include "usb.h"
 
 
+#ifndef LEDBADGE_DEFAULT_BACKEND
+#   define LEDBADGE_DEFAULT_BACKEND HidApi
+#endif
+
+
+static const unsigned short VendorId   = 0x0416;
+static const unsigned short ProductId  = 0x5020;
+static const size_t         ReportSize = 64;
+
+static std::mutex           HidMutex; // hidapi is not thread-safe
+
+// measured by the previous transfers of each backend, for the clock synchronization
+static std::atomic<double>  SecondsPerReport[3] = {{0.002}, {0.002}, {0.001}}; // by UsbBackend
+
+
 static void Log
 (
     std::function<void(const char* logString)>* logHandler,
@@ -29,34 +61,431 @@ static void Log
 }
 
 
-void SendToUsb
+// an opened badge, the write returns the number of bytes written or -1 on error
+class Connection {
+public:
+    virtual ~Connection(void) {}
+
+    virtual int Write(const unsigned char* report,
+                      size_t               size) = 0;
+};
+
+
+class HidApiConnection : public Connection {
+public:
+    HidApiConnection(hid_device* device) : m_device(device) {}
+
+    ~HidApiConnection(void) override {
+        hid_close(m_device);
+    }
+
+    int Write(const unsigned char* report,
+              size_t               size) override {
+        return hid_write(m_device, report, size);
+    }
+
+private:
+    hid_device* m_device;
+};
+
+
+#ifdef LEDBADGE_WITH_HIDRAW
+class HidrawConnection : public Connection {
+public:
+    HidrawConnection(int fileDescriptor) : m_fileDescriptor(fileDescriptor) {}
+
+    ~HidrawConnection(void) override {
+        close(m_fileDescriptor);
+    }
+
+    int Write(const unsigned char* report,
+              size_t               size) override {
+        // hidraw reports every device as writable and ignores O_NONBLOCK on
+        // writes, the kernel's USB timeout applies
+        return static_cast<int>(write(m_fileDescriptor, report, size));
+    }
+
+private:
+    int m_fileDescriptor;
+};
+#endif // LEDBADGE_WITH_HIDRAW
+
+
+// accepts the reports at the rate of a full-speed interrupt endpoint, one per frame
+class SimulatedConnection : public Connection {
+public:
+    int Write(const unsigned char*,
+              size_t size) override {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        return static_cast<int>(size);
+    }
+};
+
+
+static const char* BackendName
+(
+    UsbBackend backend
+) {
+    const char* ret = "hidapi";
+
+    switch (backend) {
+        case UsbBackend::HidApi:
+            ret = "hidapi";
+            break;
+
+        case UsbBackend::Hidraw:
+            ret = "hidraw";
+            break;
+
+        case UsbBackend::Simulated:
+            ret = "simulated";
+    }
+
+    return ret;
+}
+
+
+static std::vector<std::string> Enumerate
+(
+    UsbBackend                                  backend,
+    std::function<void(const char* logString)>* logHandler
+) {
+    std::vector<std::string> ret;
+
+    switch (backend) {
+        case UsbBackend::HidApi: {
+            hid_device_info* devices = hid_enumerate(VendorId, ProductId);
+
+            for (hid_device_info* device = devices; device != nullptr; device = device->next) {
+                if (device->path != nullptr)
+                    ret.push_back(device->path);
+            }
+
+            hid_free_enumeration(devices);
+            break;
+        }
+
+        case UsbBackend::Hidraw: {
+#ifdef LEDBADGE_WITH_HIDRAW
+            std::error_code errorCode;
+
+            for (const std::filesystem::directory_entry& entry : std::filesystem::directory_iterator("/sys/class/hidraw", errorCode)) {
+                std::ifstream uevent(entry.path() / "device" / "uevent");
+                std::string   line;
+
+                while (std::getline(uevent, line)) {
+                    // bus type USB
+                    if (line == "HID_ID=0003:00000416:00005020") {
+                        ret.push_back("/dev/" + entry.path().filename().string());
+                        break;
+                    }
+                }
+            }
+
+            if (errorCode)
+                Log(logHandler, "Error: SendToUsb(): Cannot read /sys/class/hidraw\n");
+
+            std::sort(ret.begin(), ret.end());
+#else
+            Log(logHandler, "Error: SendToUsb(): The hidraw backend is not available in this build\n");
+#endif
+            break;
+        }
+
+        case UsbBackend::Simulated:
+            ret.push_back("simulated:0");
+    }
+
+    return ret;
+}
+
+
+static std::unique_ptr<Connection> Open
+(
+    UsbBackend                                  backend,
+    const char*                                 devicePath,
+    std::function<void(const char* logString)>* logHandler
+) {
+    std::unique_ptr<Connection> ret;
+
+    switch (backend) {
+        case UsbBackend::HidApi: {
+            hid_device* device = nullptr;
+
+            if (devicePath != nullptr)
+                device = hid_open_path(devicePath);
+            else
+                device = hid_open(VendorId, ProductId, nullptr);
+
+            if (device != nullptr)
+                ret.reset(new HidApiConnection(device));
+
+            break;
+        }
+
+        case UsbBackend::Hidraw: {
+#ifdef LEDBADGE_WITH_HIDRAW
+            std::string path;
+
+            if (devicePath != nullptr)
+                path = devicePath;
+            else {
+                std::vector<std::string> devices = Enumerate(backend, logHandler);
+
+                if (devices.size() > 0)
+                    path = devices.front();
+            }
+
+            if (path.size() > 0) {
+                int fileDescriptor = open(path.c_str(), O_RDWR | O_CLOEXEC);
+
+                if (fileDescriptor >= 0)
+                    ret.reset(new HidrawConnection(fileDescriptor));
+                else {
+                    std::stringstream logstream;
+                    logstream << "Error: SendToUsb(): Cannot open " << path << ": " << strerror(errno) << "\n";
+                    Log(logHandler, logstream.str().c_str());
+                }
+            }
+#else
+            Log(logHandler, "Error: SendToUsb(): The hidraw backend is not available in this build\n");
+#endif
+            break;
+        }
+
+        case UsbBackend::Simulated:
+            ret.reset(new SimulatedConnection());
+    }
+
+    return ret;
+}
+
+
+// the badge takes over its clock when the transfer is finished, the expected
+// time of that moment is rounded to the second
+static std::chrono::system_clock::time_point PatchClock
+(
+    unsigned char* header,
+    size_t         size,
+    size_t         reportCount,
+    UsbBackend     backend
+) {
+    double                                secondsPerReport = SecondsPerReport[static_cast<size_t>(backend)].load();
+    std::chrono::system_clock::time_point finished         = std::chrono::system_clock::now()
+                                                             + std::chrono::duration_cast<std::chrono::system_clock::duration>(std::chrono::duration<double>(reportCount * secondsPerReport));
+    std::chrono::system_clock::time_point ret              = std::chrono::time_point_cast<std::chrono::seconds>(finished + std::chrono::milliseconds(500));
+    std::time_t                           time             = std::chrono::system_clock::to_time_t(ret);
+    std::tm                               localTime;
+
+    localtime_r(&time, &localTime);
+    LedBadge::PatchTime(header, size, localTime);
+
+    return ret;
+}
+
+
+static bool WriteReport
 (
-    std::vector<unsigned char>&                 data,
+    Connection&                                 connection,
+    const unsigned char*                        report,
+    const UsbTransferOptions&                   options,
+    UsbTransferStatistics&                      statistics,
     std::function<void(const char* logString)>* logHandler
 ) {
-    if (hid_init() == 0) {
-        hid_device* ledBadgeDevice = hid_open(0x0416, 0x5020, nullptr);
+    bool ret = false;
+
+    for (unsigned int attempt = 0; attempt <= options.maxRetries; ++attempt) {
+        if (attempt > 0) {
+            ++statistics.retries;
+            std::this_thread::sleep_for(std::chrono::milliseconds(options.backoff << (attempt - 1)));
+        }
+
+        int bytesWritten = connection.Write(report, ReportSize + 1);
+
+        if (bytesWritten == static_cast<int>(ReportSize + 1)) {
+            ret = true;
+            break;
+        }
+
+        std::stringstream logstream;
+        logstream << "Warning: SendToUsb(): Report write failed (" << bytesWritten << " bytes written), attempt " << (attempt + 1) << "\n";
+        Log(logHandler, logstream.str().c_str());
+    }
+
+    return ret;
+}
+
+
+UsbBackend DefaultUsbBackend(void) {
+    UsbBackend  ret         = UsbBackend::LEDBADGE_DEFAULT_BACKEND;
+    const char* backendName = getenv("LEDBADGE_USB_BACKEND");
+
+    if (backendName != nullptr)
+        ParseUsbBackend(backendName, ret);
+
+    return ret;
+}
+
+
+bool ParseUsbBackend
+(
+    const char* backendName,
+    UsbBackend& backend
+) {
+    bool ret = true;
+
+    if (strcmp(backendName, "hidapi") == 0)
+        backend = UsbBackend::HidApi;
+    else if (strcmp(backendName, "hidraw") == 0)
+        backend = UsbBackend::Hidraw;
+    else if (strcmp(backendName, "simulated") == 0)
+        backend = UsbBackend::Simulated;
+    else
+        ret = false;
+
+    return ret;
+}
+
+
+bool SendToUsb
+(
+    const std::vector<unsigned char>&           data,
+    std::function<void(const char* logString)>* logHandler,
+    UsbTransferStatistics*                      statistics,
+    const UsbTransferOptions&                   options
+) {
+    return SendToUsb(data.data(), data.size(), logHandler, statistics, options);
+}
+
+
+bool SendToUsb
+(
+    const unsigned char*                        data,
+    size_t                                      dataSize,
+    std::function<void(const char* logString)>* logHandler,
+    UsbTransferStatistics*                      statistics,
+    const UsbTransferOptions&                   options
+) {
+    bool                        ret = false;
+    UsbTransferStatistics       transferStatistics;
+    std::lock_guard<std::mutex> lock(HidMutex);
+
+    if ((options.backend != UsbBackend::HidApi) || (hid_init() == 0)) {
+        size_t                     reportCount = (dataSize + ReportSize - 1) / ReportSize;
+        std::vector<unsigned char> report(ReportSize + 1);
+
+        std::stringstream logstream;
+        logstream << "Info: SendToUsb(): Writing " << dataSize << " bytes in " << reportCount << " reports via " << BackendName(options.backend) << "\n";
+        Log(logHandler, logstream.str().c_str());
+
+        std::chrono::steady_clock::time_point start     = std::chrono::steady_clock::now();
+        std::chrono::system_clock::time_point clockTime;
+
+        for (unsigned int restart = 0; !ret && (restart <= options.maxRestarts); ++restart) {
+            if (restart > 0) {
+                ++transferStatistics.restarts;
+                Log(logHandler, "Warning: SendToUsb(): Restarting the transfer\n");
+                std::this_thread::sleep_for(std::chrono::milliseconds(options.backoff << options.maxRetries));
+            }
+
+            std::chrono::steady_clock::time_point openStart = std::chrono::steady_clock::now();
+            std::unique_ptr<Connection>           ledBadge  = Open(options.backend, options.devicePath, logHandler);
+
+            if (restart == 0)
+                transferStatistics.openSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - openStart).count();
+
+            if (ledBadge) {
+                std::chrono::steady_clock::time_point writeStart  = std::chrono::steady_clock::now();
+                size_t                                reportIndex = 0;
+
+                transferStatistics.bytesWritten = 0; // of this pass only
+
+                for (; reportIndex < reportCount; ++reportIndex) {
+                    size_t offset = reportIndex * ReportSize;
+                    size_t size   = std::min(ReportSize, dataSize - offset);
+
+                    report[0] = '\x00'; // Report ID
+                    std::copy(data + offset, data + offset + size, report.begin() + 1);
+                    std::fill(report.begin() + 1 + size, report.end(), '\x00');
+
+                    // as late as possible, on every restart again
+                    if ((reportIndex == 0) && options.synchronizeClock)
+                        clockTime = PatchClock(report.data() + 1, size, reportCount, options.backend);
+
+                    if (!WriteReport(*ledBadge, report.data(), options, transferStatistics, logHandler))
+                        break;
+
+                    transferStatistics.bytesWritten += size;
+                    ++transferStatistics.reportsWritten;
+                }
+
+                ret                             = (reportIndex == reportCount);
+                transferStatistics.writeSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - writeStart).count();
+
+                if (ret && (reportCount > 0)) {
+                    std::chrono::system_clock::time_point finished         = std::chrono::system_clock::now();
+                    double                                perReport        = transferStatistics.writeSeconds / reportCount;
+                    std::atomic<double>&                  secondsPerReport = SecondsPerReport[static_cast<size_t>(options.backend)];
 
-        if (ledBadgeDevice != nullptr) {
-            data.insert(data.begin(), '\x00'); // Report ID
+                    secondsPerReport = (secondsPerReport.load() + perReport) / 2.;
 
+                    if (options.synchronizeClock)
+                        transferStatistics.clockError = std::chrono::duration<double>(clockTime - finished).count();
+                }
+            }
+            else
+                Log(logHandler, "Error: SendToUsb(): Cannot open LED Badge device, maybe not connected?\n");
+        }
+
+        transferStatistics.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+        if (transferStatistics.writeSeconds > 0.)
+            transferStatistics.bytesPerSecond = transferStatistics.bytesWritten / transferStatistics.writeSeconds;
+
+        if (ret) {
             std::stringstream logstream;
-            logstream << "Info: SendToUsb(): Writing " << data.size() << " bytes\n";
-            Log(logHandler, logstream.str().c_str());
+            logstream << "Info: SendToUsb(): " << transferStatistics.bytesWritten << " bytes written in " << transferStatistics.writeSeconds << " s ("
+                      << transferStatistics.bytesPerSecond << " bytes/s), " << transferStatistics.seconds << " s in total, "
+                      << transferStatistics.retries << " retries, " << transferStatistics.restarts << " restarts\n";
 
-            int bytesWritten = hid_write(ledBadgeDevice, data.data(), data.size());
+            if (options.synchronizeClock)
+                logstream << "Info: SendToUsb(): Badge clock set with an error of " << transferStatistics.clockError << " s\n";
 
-            logstream.str().clear();
-            logstream << "Info: SendToUsb(): " << bytesWritten << " bytes written\n";
             Log(logHandler, logstream.str().c_str());
-
-            hid_close(ledBadgeDevice);
         }
         else
-            Log(logHandler, "Error: SendToUsb(): Cannot open LED Badge device, maybe not connected?\n");
+            Log(logHandler, "Error: SendToUsb(): Transfer failed, the badge may be programmed incompletely\n");
 
-        hid_exit();
+        if (options.backend == UsbBackend::HidApi)
+            hid_exit();
     }
     else
         Log(logHandler, "Error: SendToUsb(): Cannot initialize HID\n");
+
+    if (statistics != nullptr)
+        *statistics = transferStatistics;
+
+    return ret;
+}
+
+
+std::vector<std::string> EnumerateUsbBadges
+(
+    std::function<void(const char* logString)>* logHandler,
+    UsbBackend                                  backend
+) {
+    std::vector<std::string>    ret;
+    std::lock_guard<std::mutex> lock(HidMutex);
+
+    if ((backend != UsbBackend::HidApi) || (hid_init() == 0)) {
+        ret = Enumerate(backend, logHandler);
+
+        if (backend == UsbBackend::HidApi)
+            hid_exit();
+    }
+    else
+        Log(logHandler, "Error: EnumerateUsbBadges(): Cannot initialize HID\n");
+
+    return ret;
 }
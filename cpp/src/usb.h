@@ -16,13 +16,80 @@
 #define USB_INCLUDED
 
 #include <functional>
+#include <string>
 #include <vector>
 
 
-void SendToUsb
+enum class UsbBackend {
+    HidApi,   // the hidapi library linked at build time (libusb or hidraw)
+    Hidraw,   // /dev/hidrawN directly, Linux only
+    Simulated // no device, accepts one report per millisecond
+};
+
+
+// the backend selected at build time, or by the LEDBADGE_USB_BACKEND environment variable
+UsbBackend DefaultUsbBackend(void);
+
+
+// "hidapi", "hidraw" or "simulated", returns false for an unknown name
+bool ParseUsbBackend
+(
+    const char* backendName,
+    UsbBackend& backend
+);
+
+
+// A report write is bounded by the timeout of the backend, 1 s in hidapi-libusb
+// and the kernel's USB timeout with hidraw.  A report which failed is written
+// again after a backoff, after maxRetries the transfer restarts.
+struct UsbTransferOptions {
+    UsbBackend   backend          = DefaultUsbBackend();
+    unsigned int maxRetries       = 3;       // per report
+    unsigned int backoff          = 10;      // in ms, doubled with every retry
+    unsigned int maxRestarts      = 2;       // of the whole transfer
+    const char*  devicePath       = nullptr; // as returned by EnumerateUsbBadges(), nullptr for the first badge found
+    bool         synchronizeClock = false;   // sets the clock fields right before the header is written
+};
+
+
+struct UsbTransferStatistics {
+    size_t bytesWritten   = 0; // of the data, in the last pass over it
+    size_t reportsWritten = 0; // including the ones sent again after a restart
+    size_t retries        = 0;
+    size_t restarts       = 0;
+    double openSeconds    = 0.; // of the first open
+    double seconds        = 0.; // of the whole transfer, with the opens and restarts
+    double writeSeconds   = 0.; // of the last pass, from after the open to after the last report
+    double bytesPerSecond = 0.; // bytesWritten over writeSeconds
+    double clockError     = 0.; // with synchronizeClock, in s the badge clock is ahead when the transfer is finished
+};
+
+
+// writes the data in 64 byte reports, returns true if all reports were written
+bool SendToUsb
+(
+    const std::vector<unsigned char>&           data,
+    std::function<void(const char* logString)>* logHandler = nullptr,
+    UsbTransferStatistics*                      statistics = nullptr,
+    const UsbTransferOptions&                   options    = UsbTransferOptions()
+);
+
+
+bool SendToUsb
+(
+    const unsigned char*                        data,
+    size_t                                      dataSize,
+    std::function<void(const char* logString)>* logHandler = nullptr,
+    UsbTransferStatistics*                      statistics = nullptr,
+    const UsbTransferOptions&                   options    = UsbTransferOptions()
+);
+
+
+// the HID paths of all connected LED badges
+std::vector<std::string> EnumerateUsbBadges
 (
-    std::vector<unsigned char>&                 data,
-    std::function<void(const char* logString)>* logHandler = nullptr
+    std::function<void(const char* logString)>* logHandler = nullptr,
+    UsbBackend                                  backend    = DefaultUsbBackend()
 );
 
 
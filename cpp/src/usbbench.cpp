@@ -0,0 +1,147 @@
+/*                         U S B B E N C H . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// compares the open latency and the write throughput of the USB backends
+// usage: usbbench [-i iterations] [-v] [hidapi|hidraw|simulated ...]
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+
+#include "LedBadge.h"
+#include "usb.h"
+
+
+static double Median
+(
+    std::vector<double> values
+) {
+    double ret = 0.;
+
+    if (values.size() > 0) {
+        std::sort(values.begin(), values.end());
+        ret = values[values.size() / 2];
+    }
+
+    return ret;
+}
+
+
+// a full payload, as large as the badge accepts
+static bool BuildPayload
+(
+    std::vector<unsigned char>& data
+) {
+    LedBadge ledBadge;
+    bool     ok     = true;
+    size_t   length = (LedBadge::MaxSize - LedBadge::HeaderSize) / LedBadge::Rows / LedBadge::Banks * 8;
+
+    for (size_t i = 0; i < LedBadge::Banks; ++i)
+        ok &= ledBadge.GetMemoryBank(i).SetData(length, [](size_t x, size_t y) {return ((x + y) % 2) == 0;});
+
+    return ok && ledBadge.FetchData(data);
+}
+
+
+int main
+(
+    int    argc,
+    char** argv
+) {
+    int                                        ret        = EXIT_SUCCESS;
+    size_t                                     iterations = 10;
+    std::vector<UsbBackend>                    backends;
+    std::vector<const char*>                   backendNames;
+    std::function<void(const char* logString)> logHandler = [](const char* logString){std::cerr << logString;};
+    bool                                       verbose    = false;
+
+    for (int i = 1; i < argc; ++i) {
+        UsbBackend backend;
+
+        if ((strcmp(argv[i], "-i") == 0) && (i + 1 < argc))
+            iterations = std::max(atoi(argv[++i]), 1);
+        else if (strcmp(argv[i], "-v") == 0)
+            verbose = true;
+        else if (ParseUsbBackend(argv[i], backend)) {
+            backends.push_back(backend);
+            backendNames.push_back(argv[i]);
+        }
+        else {
+            std::cerr << "usage: " << argv[0] << " [-i iterations] [-v] [hidapi|hidraw|simulated ...]\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (backends.size() == 0) {
+        backends     = {UsbBackend::HidApi, UsbBackend::Hidraw};
+        backendNames = {"hidapi", "hidraw"};
+    }
+
+    std::vector<unsigned char> data;
+
+    if (!BuildPayload(data)) {
+        std::cerr << "Error: usbbench: Cannot build the payload\n";
+        return EXIT_FAILURE;
+    }
+
+    std::cout << "payload: " << data.size() << " bytes, " << iterations << " iterations\n";
+    std::cout << "backend      open min [ms]  open median [ms]  open max [ms]  median throughput [bytes/s]  failures\n";
+
+    for (size_t i = 0; i < backends.size(); ++i) {
+        UsbTransferOptions  options;
+        std::vector<double> openTimes;
+        std::vector<double> throughputs;
+        size_t              failures = 0;
+
+        options.backend = backends[i];
+
+        for (size_t iteration = 0; iteration < iterations; ++iteration) {
+            UsbTransferStatistics statistics;
+
+            if (SendToUsb(data, verbose ? &logHandler : nullptr, &statistics, options)) {
+                openTimes.push_back(statistics.openSeconds * 1000.);
+                throughputs.push_back(statistics.bytesPerSecond);
+            }
+            else
+                ++failures;
+        }
+
+        std::cout.width(13);
+        std::cout << std::left << backendNames[i] << std::right;
+
+        if (openTimes.size() > 0) {
+            std::cout.width(13);
+            std::cout << *std::min_element(openTimes.begin(), openTimes.end());
+            std::cout.width(18);
+            std::cout << Median(openTimes);
+            std::cout.width(15);
+            std::cout << *std::max_element(openTimes.begin(), openTimes.end());
+            std::cout.width(29);
+            std::cout << Median(throughputs);
+        }
+        else {
+            std::cout.width(75);
+            std::cout << "-";
+        }
+
+        std::cout.width(10);
+        std::cout << failures << "\n";
+
+        if (failures > 0)
+            ret = EXIT_FAILURE;
+    }
+
+    return ret;
+}
@@ -0,0 +1,181 @@
+/*           C O N C U R R E N T L E D B A D G E T E S T . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// checks that FetchData() copies a state which existed and that concurrent
+// updates of one bank are not lost
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <thread>
+
+#include "ConcurrentLedBadge.h"
+
+
+static const size_t Snapshots = 200000;
+static const size_t Rounds    = 2000;
+static const size_t Repeats   = 8; // updates per thread and round
+
+
+// the counter stored in the first bytes of a bank
+static unsigned long GetCounter
+(
+    const std::vector<unsigned char>& data,
+    size_t                            index
+) {
+    unsigned long ret        = 0;
+    size_t        bankOffset = 0;
+    size_t        bankSize   = 0;
+
+    if (LedBadge::FindBankData(data.data(), data.size(), index, bankOffset, bankSize) && (bankSize >= 4)) {
+        for (size_t i = 0; i < 4; ++i)
+            ret |= static_cast<unsigned long>(data[bankOffset + i]) << (8 * i);
+    }
+
+    return ret;
+}
+
+
+static bool SetCounter
+(
+    ConcurrentLedBadge& badge,
+    size_t              index,
+    unsigned long       counter
+) {
+    unsigned char data[LedBadge::Rows] = {};
+
+    for (size_t i = 0; i < 4; ++i)
+        data[i] = static_cast<unsigned char>(counter >> (8 * i));
+
+    return badge.GetMemoryBank(index).SetPackedData(data, sizeof(data));
+}
+
+
+// the writer sets bank 0 and then bank 1 to the same counter, so a copy has
+// bank 0 equal to bank 1 or one ahead
+static bool CheckSnapshots
+(
+    std::function<void(const char* logString)>& logHandler
+) {
+    ConcurrentLedBadge badge(&logHandler);
+    std::atomic<bool>  stop(false);
+    size_t             failed = 0;
+    size_t             mixed  = 0;
+
+    std::thread writer([&badge, &stop]() {
+        for (unsigned long counter = 1; !stop.load(); ++counter) {
+            SetCounter(badge, 0, counter);
+            SetCounter(badge, 1, counter);
+        }
+    });
+
+    for (size_t i = 0; i < Snapshots; ++i) {
+        std::vector<unsigned char> data;
+
+        if (badge.FetchData(data)) {
+            unsigned long bank0 = GetCounter(data, 0);
+            unsigned long bank1 = GetCounter(data, 1);
+
+            if ((bank0 != bank1) && (bank0 != bank1 + 1)) {
+                if (mixed == 0)
+                    std::cerr << "bank0=" << bank0 << " bank1=" << bank1 << std::endl;
+
+                ++mixed;
+            }
+        }
+        else
+            ++failed;
+    }
+
+    stop.store(true);
+    writer.join();
+
+    std::cout << "snapshots: " << Snapshots << ", mixed " << mixed << ", failed " << failed << std::endl;
+
+    return mixed == 0;
+}
+
+
+// four threads set a different field of bank 0 each, all of their last values
+// have to be in the data
+static bool CheckUpdates
+(
+    std::function<void(const char* logString)>& logHandler
+) {
+    ConcurrentLedBadge badge(&logHandler);
+    size_t             lost = 0;
+
+    for (size_t round = 0; round < Rounds; ++round) {
+        ConcurrentLedBadge::MemoryBank memoryBank = badge.GetMemoryBank(0);
+        bool                           on         = (round % 2) == 0;
+        LedBadge::Mode                 mode       = static_cast<LedBadge::Mode>(round % 9);
+        LedBadge::Speed                speed      = static_cast<LedBadge::Speed>(round % 8);
+
+        std::thread blinking([&memoryBank, on]() {
+            for (size_t i = 0; i < Repeats; ++i)
+                memoryBank.SetBlinking(((Repeats - 1 - i) % 2 == 0) ? on : !on);
+        });
+        std::thread animatedBorder([&memoryBank, on]() {
+            for (size_t i = 0; i < Repeats; ++i)
+                memoryBank.SetAnimatedBorder(((Repeats - 1 - i) % 2 == 0) ? !on : on);
+        });
+        std::thread modeSetter([&memoryBank, mode]() {
+            for (size_t i = 0; i < Repeats; ++i)
+                memoryBank.SetMode(mode);
+        });
+        std::thread speedSetter([&memoryBank, speed]() {
+            for (size_t i = 0; i < Repeats; ++i)
+                memoryBank.SetSpeed(speed);
+        });
+
+        blinking.join();
+        animatedBorder.join();
+        modeSetter.join();
+        speedSetter.join();
+
+        LedBadge                   expected;
+        std::vector<unsigned char> expectedData;
+        std::vector<unsigned char> data;
+
+        expected.GetMemoryBank(0).SetBlinking(on);
+        expected.GetMemoryBank(0).SetAnimatedBorder(!on);
+        expected.GetMemoryBank(0).SetMode(mode);
+        expected.GetMemoryBank(0).SetSpeed(speed);
+
+        if (!expected.FetchData(expectedData) || !badge.FetchData(data) || (data != expectedData))
+            ++lost;
+    }
+
+    std::cout << "update rounds: " << Rounds << ", lost " << lost << std::endl;
+
+    return lost == 0;
+}
+
+
+int main
+(
+    int,
+    char**
+) {
+    int                                        ret        = EXIT_SUCCESS;
+    std::function<void(const char* logString)> logHandler = [](const char* logString){std::cerr << logString;};
+
+    if (!CheckSnapshots(logHandler))
+        ret = EXIT_FAILURE;
+
+    if (!CheckUpdates(logHandler))
+        ret = EXIT_FAILURE;
+
+    return ret;
+}
@@ -0,0 +1,142 @@
+/*               P A C K E D B I T M A P T E S T . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// compares the blits at all column offsets, the aligned and the unaligned
+// ones and the ones clipped at the right edge, with a blit pixel by pixel
+
+#include <cstdlib>
+#include <iostream>
+#include <random>
+
+#include "PackedBitmap.h"
+
+
+static const PackedBitmap::Operation Operations[] = {
+    PackedBitmap::Operation::Copy,
+    PackedBitmap::Operation::Or,
+    PackedBitmap::Operation::AndNot,
+    PackedBitmap::Operation::Xor
+};
+
+
+static PackedBitmap RandomBitmap
+(
+    size_t        width,
+    std::mt19937& random
+) {
+    return PackedBitmap(width, [&random](size_t, size_t) {return (random() % 2) == 0;});
+}
+
+
+static bool Combine
+(
+    bool                    destination,
+    bool                    source,
+    PackedBitmap::Operation operation
+) {
+    bool ret = destination;
+
+    switch (operation) {
+        case PackedBitmap::Operation::Copy:
+            ret = source;
+            break;
+
+        case PackedBitmap::Operation::Or:
+            ret = destination || source;
+            break;
+
+        case PackedBitmap::Operation::AndNot:
+            ret = destination && !source;
+            break;
+
+        case PackedBitmap::Operation::Xor:
+            ret = destination != source;
+    }
+
+    return ret;
+}
+
+
+// the bits right of the width have to stay 0
+static bool PaddingIsClear
+(
+    const PackedBitmap& bitmap
+) {
+    bool   ret         = true;
+    size_t byteColumns = bitmap.Data().size() / PackedBitmap::Rows;
+
+    for (size_t byteColumn = 0; byteColumn < byteColumns; ++byteColumn) {
+        for (size_t bit = 0; bit < 8; ++bit) {
+            size_t x = 8 * byteColumn + bit;
+
+            for (size_t y = 0; (x >= bitmap.Width()) && (y < PackedBitmap::Rows); ++y)
+                ret &= ((bitmap.Data()[PackedBitmap::Rows * byteColumn + y] >> (7 - bit)) & 1) == 0;
+        }
+    }
+
+    return ret;
+}
+
+
+int main
+(
+    int,
+    char**
+) {
+    std::mt19937 random(44);
+    size_t       blits    = 0;
+    size_t       failures = 0;
+
+    for (size_t width = 1; width <= 40; ++width) {
+        for (size_t sourceWidth = 1; sourceWidth <= 20; ++sourceWidth) {
+            for (size_t x = 0; x <= width + 1; ++x) {
+                for (PackedBitmap::Operation operation : Operations) {
+                    PackedBitmap destination = RandomBitmap(width, random);
+                    PackedBitmap source      = RandomBitmap(sourceWidth, random);
+                    PackedBitmap result      = destination;
+                    bool         ok          = true;
+
+                    result.Blit(source, x, operation);
+
+                    for (size_t column = 0; column < width; ++column) {
+                        for (size_t y = 0; y < PackedBitmap::Rows; ++y) {
+                            bool expected = destination.Get(column, y);
+
+                            if ((column >= x) && (column < x + sourceWidth))
+                                expected = Combine(expected, source.Get(column - x, y), operation);
+
+                            ok &= (result.Get(column, y) == expected);
+                        }
+                    }
+
+                    ok &= (result.Width() == width) && PaddingIsClear(result);
+
+                    if (!ok) {
+                        if (failures == 0)
+                            std::cerr << "blit of width " << sourceWidth << " at " << x << " into width " << width
+                                      << " failed, operation " << static_cast<int>(operation) << std::endl;
+
+                        ++failures;
+                    }
+
+                    ++blits;
+                }
+            }
+        }
+    }
+
+    std::cout << "blits: " << blits << ", failed " << failures << std::endl;
+
+    return (failures == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}
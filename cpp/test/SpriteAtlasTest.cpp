@@ -0,0 +1,71 @@
+/*                S P R I T E A T L A S T E S T . C P P
+ *
+ * Permission to use, copy, modify, and/or distribute this software for any
+ * purpose with or without fee is hereby granted.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES
+ * WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF
+ * MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY
+ * SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES WHATSOEVER
+ * RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN ACTION OF
+ * CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF OR IN
+ * CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.
+ */
+
+// saves an atlas and loads it again, a loaded sprite replaces the one with
+// the same name
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+
+#include "SpriteAtlas.h"
+
+
+static bool Equal
+(
+    const PackedBitmap* bitmap,
+    const PackedBitmap& expected
+) {
+    return (bitmap != nullptr) && (bitmap->Width() == expected.Width()) && (bitmap->Data() == expected.Data());
+}
+
+
+int main
+(
+    int,
+    char**
+) {
+    int                                        ret        = EXIT_SUCCESS;
+    std::function<void(const char* logString)> logHandler = [](const char* logString){std::cerr << logString;};
+    std::string                                fileName   = "SpriteAtlasTest.lbsa";
+    PackedBitmap                               heart(9, [](size_t x, size_t y) {return ((x + y) % 3) == 0;});
+    PackedBitmap                               arrow(17, [](size_t x, size_t y) {return x == y;});
+    PackedBitmap                               empty(0);
+    PackedBitmap                               oldArrow(5, [](size_t, size_t) {return true;});
+    SpriteAtlas                                saved(&logHandler);
+    SpriteAtlas                                loaded(&logHandler);
+
+    saved.Add("heart", heart);
+    saved.Add("arrow", arrow);
+    saved.Add("empty", empty);
+
+    loaded.Add("arrow", oldArrow);
+    loaded.Add("other", heart);
+
+    if (!saved.Save(fileName.c_str()) || !loaded.Load(fileName.c_str())) {
+        std::cerr << "the atlas could not be saved or loaded" << std::endl;
+        ret = EXIT_FAILURE;
+    }
+    else if (!Equal(loaded.Find("heart"), heart) || !Equal(loaded.Find("arrow"), arrow) || !Equal(loaded.Find("empty"), empty) ||
+             !Equal(loaded.Find("other"), heart) || (loaded.Size() != 4)) {
+        std::cerr << "the loaded atlas differs" << std::endl;
+        ret = EXIT_FAILURE;
+    }
+
+    std::remove(fileName.c_str());
+
+    std::cout << "sprite atlas round trip " << ((ret == EXIT_SUCCESS) ? "passed" : "failed") << std::endl;
+
+    return ret;
+}